@@ -0,0 +1,32 @@
+#ifndef ASYNCFILEDATASINK_H
+#define ASYNCFILEDATASINK_H
+
+#include <memory>
+#include <string>
+#include "DataSink.h"
+
+// File sink that keeps several block writes in flight. Uses io_uring with
+// registered buffers when built with the kernel io_uring header (HAVE_IO_URING)
+// and falls back to pwrite otherwise, or when the ring cannot be set up at
+// runtime.
+class CAsyncFileDataSink : public CDataSink{
+    private:
+        struct SImplementation;
+        std::unique_ptr<SImplementation> DImplementation;
+
+    public:
+        CAsyncFileDataSink(const std::string &filename, bool durable = false, std::size_t blocksize = 256 * 1024, std::size_t depth = 4);
+        ~CAsyncFileDataSink();
+
+        bool IsOpen() const noexcept;
+        bool IsAsync() const noexcept;
+        bool Flush() noexcept;
+        bool Close() noexcept;
+
+        using CDataSink::Write;
+        bool Put(const char &ch) noexcept override;
+        bool Write(const std::vector<char> &buf) noexcept override;
+        bool Write(const char *data, std::size_t length) noexcept override;
+};
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef ASYNCFILEDATASOURCE_H
+#define ASYNCFILEDATASOURCE_H
+
+#include <memory>
+#include <string>
+#include "DataSource.h"
+
+// File source that keeps several block reads in flight. Uses io_uring with
+// registered buffers when built with the kernel io_uring header (HAVE_IO_URING)
+// and falls back to pread otherwise, or when the ring cannot be set up at
+// runtime.
+class CAsyncFileDataSource : public CDataSource{
+    private:
+        struct SImplementation;
+        std::unique_ptr<SImplementation> DImplementation;
+
+    public:
+        CAsyncFileDataSource(const std::string &filename, std::size_t blocksize = 256 * 1024, std::size_t depth = 4);
+        ~CAsyncFileDataSource();
+
+        bool IsOpen() const noexcept;
+        bool IsAsync() const noexcept;
+        // A failed read ends the data like the end of the file does, these
+        // tell the two apart. ErrorNumber is the errno of the failure.
+        bool Error() const noexcept;
+        int ErrorNumber() const noexcept;
+
+        bool End() const noexcept override;
+        bool Get(char &ch) noexcept override;
+        bool Peek(char &ch) noexcept override;
+        bool Read(std::vector<char> &buf, std::size_t count) noexcept override;
+        bool PeekBlock(const char *&data, std::size_t &length) noexcept override;
+        std::size_t Consume(std::size_t count) noexcept override;
+};
+
+#endif
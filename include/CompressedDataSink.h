@@ -0,0 +1,31 @@
+#ifndef COMPRESSEDDATASINK_H
+#define COMPRESSEDDATASINK_H
+
+#include <memory>
+#include "DataSink.h"
+
+// Compresses everything written to it into another sink. Gzip and zlib use
+// zlib, zstd is available when built with HAVE_ZSTD. The stream is completed
+// by Close() or on destruction.
+class CCompressedDataSink : public CDataSink{
+    private:
+        struct SImplementation;
+        std::unique_ptr<SImplementation> DImplementation;
+
+    public:
+        enum class EFormat{Gzip, Zlib, Zstd};
+
+        CCompressedDataSink(std::shared_ptr< CDataSink > sink, EFormat format = EFormat::Gzip, int level = -1, std::size_t blocksize = 256 * 1024);
+        ~CCompressedDataSink();
+
+        bool IsOpen() const noexcept;
+        bool Flush() noexcept;
+        bool Close() noexcept;
+
+        using CDataSink::Write;
+        bool Put(const char &ch) noexcept override;
+        bool Write(const std::vector<char> &buf) noexcept override;
+        bool Write(const char *data, std::size_t length) noexcept override;
+};
+
+#endif
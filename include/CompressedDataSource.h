@@ -0,0 +1,34 @@
+#ifndef COMPRESSEDDATASOURCE_H
+#define COMPRESSEDDATASOURCE_H
+
+#include <memory>
+#include "DataSource.h"
+
+// Decompresses another source on the fly. The format is detected from the
+// leading magic bytes: gzip and zlib streams are inflated with zlib, zstd
+// frames are decoded when built with HAVE_ZSTD, anything else passes through.
+// Text can carry a valid zlib header, so such input passes through as well
+// when inflating its first block fails and Format then reports Plain.
+class CCompressedDataSource : public CDataSource{
+    private:
+        struct SImplementation;
+        std::unique_ptr<SImplementation> DImplementation;
+
+    public:
+        enum class EFormat{Plain, Gzip, Zlib, Zstd};
+
+        CCompressedDataSource(std::shared_ptr< CDataSource > src, std::size_t blocksize = 256 * 1024);
+        ~CCompressedDataSource();
+
+        EFormat Format() const noexcept;
+        bool Error() const noexcept;
+
+        bool End() const noexcept override;
+        bool Get(char &ch) noexcept override;
+        bool Peek(char &ch) noexcept override;
+        bool Read(std::vector<char> &buf, std::size_t count) noexcept override;
+        bool PeekBlock(const char *&data, std::size_t &length) noexcept override;
+        std::size_t Consume(std::size_t count) noexcept override;
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef DSVCACHE_H
+#define DSVCACHE_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Binary columnar copy of a DSV file. Columns whose every value round trips
+// as a 64-bit integer are stored as integers, columns with few distinct values
+// as dictionary codes, and the rest as offsets into their bytes. The cache
+// records the size and modification time of the DSV file it was built from.
+class CDSVCache{
+    public:
+        // Parses the DSV file and writes its cache, replacing any old one
+        static bool Build(const std::string &filename, char delimiter, const std::string &cachefilename);
+        // True if the cache is intact and matches the current DSV file
+        static bool Valid(const std::string &filename, char delimiter, const std::string &cachefilename);
+};
+
+// Reads the rows of a DSV file from its cache without parsing. A missing or
+// stale cache is rebuilt on construction, and if it cannot be written the
+// rows are served from the image built in memory.
+class CDSVCacheReader{
+    private:
+        struct SImplementation;
+        std::unique_ptr<SImplementation> DImplementation;
+
+    public:
+        CDSVCacheReader(const std::string &filename, char delimiter, const std::string &cachefilename);
+        ~CDSVCacheReader();
+
+        // False if neither the cache nor the DSV file could be read
+        bool IsOpen() const noexcept;
+        // True if the rows come from a cache that was already up to date
+        bool FromCache() const noexcept;
+        std::size_t RowCount() const noexcept;
+
+        // Positions the reader so the next row read is row
+        bool SeekRow(std::size_t row) noexcept;
+        bool End() const noexcept;
+        bool ReadRow(std::vector<std::string> &row);
+        // Fields point into the cache, valid until the next read
+        bool ReadRowView(std::vector<std::string_view> &row);
+};
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef DSVCOLUMNREADER_H
+#define DSVCOLUMNREADER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "DataSource.h"
+
+struct SDSVColumn{
+    enum class EType{Int64, Double, Bool, String};
+    EType DType;
+    // Only the vector matching DType is filled, one entry per row
+    std::vector< std::int64_t > DInt64;
+    std::vector< double > DDouble;
+    std::vector< std::uint8_t > DBool;
+    // String row i is DBytes[DOffsets[i], DOffsets[i + 1])
+    std::vector< std::size_t > DOffsets;
+    std::string DBytes;
+    // 1 where the field was present and parsed as DType, else the value is 0
+    std::vector< std::uint8_t > DValid;
+
+    std::string_view StringValue(std::size_t row) const{
+        return std::string_view(DBytes.data() + DOffsets[row], DOffsets[row + 1] - DOffsets[row]);
+    };
+};
+
+struct SDSVColumnBatch{
+    std::size_t DRowCount = 0;
+    std::vector< SDSVColumn > DColumns;
+};
+
+// Reads DSV rows into typed column buffers a batch at a time. The buffers of
+// a batch are reused, so reading into the same batch again does not allocate
+// once they have grown to the batch size.
+class CDSVColumnReader{
+    private:
+        struct SImplementation;
+        std::unique_ptr<SImplementation> DImplementation;
+
+    public:
+        CDSVColumnReader(std::shared_ptr< CDataSource > src, char delimiter, const std::vector< SDSVColumn::EType > &types);
+        ~CDSVColumnReader();
+
+        bool End() const;
+        // Replaces the batch contents with up to maxrows rows, false if none remain
+        bool ReadBatch(SDSVColumnBatch &batch, std::size_t maxrows);
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef DSVHEADERREADER_H
+#define DSVHEADERREADER_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "DataSource.h"
+
+// Reads the first row as the header and looks column names up in a flat hash
+// table, so fields of the current row can be fetched by name in constant time.
+class CDSVHeaderReader{
+    private:
+        struct SImplementation;
+        std::unique_ptr<SImplementation> DImplementation;
+
+    public:
+        static constexpr std::size_t NoColumn = std::size_t(-1);
+
+        CDSVHeaderReader(std::shared_ptr< CDataSource > src, char delimiter);
+        ~CDSVHeaderReader();
+
+        const std::vector<std::string> &Header() const noexcept;
+        // Index of the first column with the name, NoColumn if there is none
+        std::size_t Column(std::string_view name) const noexcept;
+
+        bool End() const;
+        bool ReadRow(std::vector<std::string> &row);
+        // Fields point into the reader's buffers, valid until the next read
+        bool ReadRowView(std::vector<std::string_view> &row);
+
+        // Fields of the last row read, empty if the column or field is missing
+        std::string_view Field(std::size_t column) const noexcept;
+        std::string_view Field(std::string_view name) const noexcept;
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef DSVINDEX_H
+#define DSVINDEX_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "DataSink.h"
+#include "DataSource.h"
+
+// Byte offsets of every interval-th row of a DSV input, found with the same
+// quoting rules as CDSVReader. Saved as a small sidecar of delta encoded
+// varints so the input does not have to be rescanned.
+class CDSVIndex{
+    private:
+        std::size_t DInterval;
+        std::size_t DRowCount;
+        std::uint64_t DDataSize;
+        std::vector< std::uint64_t > DOffsets;
+
+    public:
+        CDSVIndex(std::size_t interval = 1024);
+
+        std::size_t Interval() const noexcept;
+        std::size_t RowCount() const noexcept;
+        std::uint64_t DataSize() const noexcept;
+
+        // Scans the whole source, which must be positioned at its start
+        void Build(std::shared_ptr< CDataSource > src, char delimiter);
+        bool Save(std::shared_ptr< CDataSink > sink) const;
+        bool Load(std::shared_ptr< CDataSource > src);
+
+        // Offset of the closest indexed row at or before row, and the number of
+        // rows to skip from there. Fails if row is past the last row.
+        bool Locate(std::size_t row, std::uint64_t &offset, std::size_t &skip) const noexcept;
+};
+
+// Reads rows like CDSVReader but can jump to any row through an index of the
+// same input. The source must support Seek.
+class CDSVIndexedReader{
+    private:
+        struct SImplementation;
+        std::unique_ptr<SImplementation> DImplementation;
+
+    public:
+        CDSVIndexedReader(std::shared_ptr< CDataSource > src, char delimiter, std::shared_ptr< const CDSVIndex > index);
+        ~CDSVIndexedReader();
+
+        // Positions the reader so the next row read is row, false if it cannot.
+        // Also false when the source does not match the index: its size must
+        // be the index's DataSize and an indexed row must start after a
+        // newline.
+        bool SeekRow(std::size_t row);
+        // Number of the next row to be read
+        std::size_t Row() const;
+
+        bool End() const;
+        bool ReadRow(std::vector<std::string> &row);
+        // Fields point into the reader's buffers, valid until the next read
+        bool ReadRowView(std::vector<std::string_view> &row);
+};
+
+#endif
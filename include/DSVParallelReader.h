@@ -0,0 +1,37 @@
+#ifndef DSVPARALLELREADER_H
+#define DSVPARALLELREADER_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "DataSource.h"
+
+// Parses DSV data on a pool of worker threads. The input is cut into chunks
+// at newlines, a quote aware scan of each chunk finds where its first row
+// really starts, and each chunk is then parsed with a CDSVReader. Rows are
+// identical to those of a sequential CDSVReader; when ordered is false they
+// are delivered chunk by chunk as soon as any chunk is done.
+class CDSVParallelReader{
+    private:
+        struct SImplementation;
+        std::unique_ptr<SImplementation> DImplementation;
+
+    public:
+        // Memory mapped file sources are parsed in place, other sources are
+        // read a window of about four chunks per thread at a time, at most
+        // 64 MB or one chunk if larger. Reading such a source peaks at a few
+        // times the window: the window, the next one as it is read, and the
+        // parsed rows of the chunks in flight.
+        CDSVParallelReader(std::shared_ptr< CDataSource > src, char delimiter, bool ordered = true, std::size_t threads = 0, std::size_t chunksize = 4 * 1024 * 1024);
+        // Borrows the bytes, the caller keeps them alive while they are read
+        CDSVParallelReader(std::string_view data, char delimiter, bool ordered = true, std::size_t threads = 0, std::size_t chunksize = 4 * 1024 * 1024);
+        ~CDSVParallelReader();
+
+        bool End() const;
+        bool ReadRow(std::vector<std::string> &row);
+        // Fields point into the reader's buffers, valid until the next read
+        bool ReadRowView(std::vector<std::string_view> &row);
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef DSVPARALLELWRITER_H
+#define DSVPARALLELWRITER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "DataSink.h"
+
+// Formats batches of DSV rows on a pool of worker threads and writes them to
+// the sink from a committer thread in the order they were submitted. The
+// output is byte for byte what one CDSVWriter would produce.
+class CDSVParallelWriter{
+    private:
+        struct SImplementation;
+        std::unique_ptr<SImplementation> DImplementation;
+
+    public:
+        // At most 4 * threads batches are queued before WriteRows waits
+        CDSVParallelWriter(std::shared_ptr< CDataSink > sink, char delimiter, bool quoteall = false, std::size_t threads = 0);
+        // Waits for all queued batches to be written
+        ~CDSVParallelWriter();
+
+        // Queues the rows, move them in to avoid a copy. False once any write
+        // to the sink has failed.
+        bool WriteRows(std::vector<std::vector<std::string>> rows);
+        // Waits until every queued batch is written, false if any write failed
+        bool Flush();
+};
+
+#endif
@@ -3,7 +3,10 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "DataSource.h"
+#include "DSVRowBatch.h"
 
 class CDSVReader{
     private:
@@ -12,10 +15,26 @@ class CDSVReader{
 
     public:
         CDSVReader(std::shared_ptr< CDataSource > src, char delimiter);
+        // Only returns the given columns, in the given order. Other fields are
+        // scanned past but never copied, missing columns read as empty.
+        CDSVReader(std::shared_ptr< CDataSource > src, char delimiter, const std::vector<size_t> &columns);
+        // As above, taking the columns by name from the header row
+        CDSVReader(std::shared_ptr< CDataSource > src, char delimiter, const std::vector<std::string> &columns);
         ~CDSVReader();
 
+        // Only returns rows where some field contains text. Rows whose raw
+        // bytes lack the text are skipped without being split into fields.
+        void FilterContains(std::string_view text);
+        // Only returns rows whose field in the given input column, counted
+        // before any projection, equals value. Prefiltered the same way.
+        void FilterEquals(size_t column, std::string_view value);
+
         bool End() const;
         bool ReadRow(std::vector<std::string> &row);
+        // Fields point into the reader's buffers, valid until the next read
+        bool ReadRowView(std::vector<std::string_view> &row);
+        // Replaces the batch contents with up to maxrows rows, false if none remain
+        bool ReadRows(CDSVRowBatch &batch, size_t maxrows);
 };
 
 #endif
@@ -0,0 +1,63 @@
+#ifndef DSVROWBATCH_H
+#define DSVROWBATCH_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Rows of DSV fields stored back to back in one arena. Field and row ends are
+// offsets, so clearing and refilling a batch reuses all of its memory.
+class CDSVRowBatch{
+    private:
+        std::string DData;
+        std::vector< std::size_t > DFieldEnds;
+        std::vector< std::size_t > DRowEnds;
+
+    public:
+        void Clear() noexcept{
+            DData.clear();
+            DFieldEnds.clear();
+            DRowEnds.clear();
+        };
+
+        void AppendField(std::string_view field){
+            DData.append(field.data(), field.size());
+            DFieldEnds.push_back(DData.size());
+        };
+
+        // Closes the row made of the fields appended since the last one
+        void EndRow(){
+            DRowEnds.push_back(DFieldEnds.size());
+        };
+
+        void Reserve(std::size_t bytes){
+            DData.reserve(bytes);
+        };
+
+        std::size_t RowCount() const noexcept{
+            return DRowEnds.size();
+        };
+
+        std::size_t FieldCount(std::size_t row) const noexcept{
+            return DRowEnds[row] - (row ? DRowEnds[row - 1] : 0);
+        };
+
+        std::string_view Field(std::size_t row, std::size_t field) const noexcept{
+            std::size_t Index = (row ? DRowEnds[row - 1] : 0) + field;
+            std::size_t Begin = Index ? DFieldEnds[Index - 1] : 0;
+            return std::string_view(DData.data() + Begin, DFieldEnds[Index] - Begin);
+        };
+
+        // Views of the fields of a row, valid until the batch is changed
+        void Row(std::size_t row, std::vector< std::string_view > &fields) const{
+            std::size_t Index = row ? DRowEnds[row - 1] : 0;
+            std::size_t Begin = Index ? DFieldEnds[Index - 1] : 0;
+            fields.resize(DRowEnds[row] - Index);
+            for(auto &Field : fields){
+                Field = std::string_view(DData.data() + Begin, DFieldEnds[Index] - Begin);
+                Begin = DFieldEnds[Index++];
+            }
+        };
+};
+
+#endif
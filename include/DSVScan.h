@@ -0,0 +1,39 @@
+#ifndef DSVSCAN_H
+#define DSVSCAN_H
+
+#include <cstddef>
+
+namespace DSVScan{
+
+// Returns the first delimiter, double quote or newline in [begin, end), or
+// end if there is none. Scans 16 or 32 bytes at a time where SIMD is available.
+const char *FindStructural(const char *begin, const char *end, char delimiter) noexcept;
+
+// Returns the first occurrence of the length byte needle in [begin, end), or
+// end if there is none. Candidates are found by matching the first and last
+// needle bytes 16 or 32 positions at a time.
+const char *FindSubstring(const char *begin, const char *end, const char *needle, std::size_t length) noexcept;
+
+enum class EScanState{FieldStart, Unquoted, Quoted, QuotePending};
+
+// Follows the reader's quoting rules over [begin, end) from state and returns
+// the position just past the newline ending the current row, or nullptr if
+// the row does not end in the range. state is updated for the next call.
+const char *NextRow(const char *begin, const char *end, char delimiter, EScanState &state) noexcept;
+
+// Follows the reader's quoting rules over [begin, end), starting at the start
+// of a row or, when quoted is set, inside a quoted field. rowstart is set to
+// the first row start seen (nullptr if none) and the result tells whether end
+// lies inside a quoted field.
+bool ScanRows(const char *begin, const char *end, char delimiter, bool quoted, const char *&rowstart) noexcept;
+
+// Returns the start of the row holding position, where begin is a row start,
+// or of an earlier row with text after the closing quote of a field, since
+// removing that quote joins text that was apart in the raw bytes. Rows are
+// only followed with the quoting rules up to the last quote before position,
+// past it every newline ends a row.
+const char *FindRowStart(const char *begin, const char *position, char delimiter) noexcept;
+
+}
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 #include "DataSink.h"
 
 class CDSVWriter{
@@ -15,6 +16,9 @@ class CDSVWriter{
         ~CDSVWriter();
 
         bool WriteRow(const std::vector<std::string> &row);
+        // Writes the rows exactly as repeated WriteRow calls would, but formats
+        // them into one buffer handed to the sink in large blocks
+        bool WriteRows(const std::vector<std::vector<std::string>> &rows);
 };
 
 #endif
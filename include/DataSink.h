@@ -2,12 +2,38 @@
 #define DATASINK_H
 
 #include <vector>
+#include <cstddef>
+#include <string_view>
 
 class CDataSink{
     public:
         virtual ~CDataSink(){};
         virtual bool Put(const char &ch) noexcept = 0;
         virtual bool Write(const std::vector<char> &buf) noexcept = 0;
+
+        // Writes length bytes, the default falls back to Put per byte
+        virtual bool Write(const char *data, std::size_t length) noexcept{
+            for(std::size_t Index = 0; Index < length; Index++){
+                if(!Put(data[Index])){
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        bool Write(std::string_view str) noexcept{
+            return Write(str.data(), str.size());
+        };
+
+        // Writes the segments in order as one gathered write
+        virtual bool WriteV(const std::string_view *segments, std::size_t count) noexcept{
+            for(std::size_t Index = 0; Index < count; Index++){
+                if(!Write(segments[Index].data(), segments[Index].size())){
+                    return false;
+                }
+            }
+            return true;
+        };
 };
 
 #endif
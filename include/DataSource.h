@@ -2,14 +2,52 @@
 #define DATASOURCE_H
 
 #include <vector>
+#include <cstddef>
 
 class CDataSource{
+    private:
+        char DBlockChar;
+
     public:
         virtual ~CDataSource(){};
+        // True when no bytes are left. End only looks ahead: it must not
+        // consume, move or overwrite the bytes of an outstanding PeekBlock
+        // view, so callers may ask it while holding one. Sources that need to
+        // read to find out read into spare storage.
         virtual bool End() const noexcept = 0;
         virtual bool Get(char &ch) noexcept = 0;
         virtual bool Peek(char &ch) noexcept = 0;
         virtual bool Read(std::vector<char> &buf, std::size_t count) noexcept = 0;
+
+        // Exposes the next contiguous run of available bytes without consuming
+        // them. The view stays valid until the next call to PeekBlock, Get,
+        // Peek or Read (Consume and End do not invalidate it). The default falls back
+        // to a single byte from Peek; sources with a buffer should override.
+        virtual bool PeekBlock(const char *&data, std::size_t &length) noexcept{
+            if(!Peek(DBlockChar)){
+                length = 0;
+                return false;
+            }
+            data = &DBlockChar;
+            length = 1;
+            return true;
+        };
+
+        // Consumes up to count bytes, returns the number actually consumed
+        virtual std::size_t Consume(std::size_t count) noexcept{
+            std::size_t Consumed = 0;
+            char TempChar;
+            while(Consumed < count && Get(TempChar)){
+                Consumed++;
+            }
+            return Consumed;
+        };
+
+        // Moves to an absolute byte offset from the start of the source.
+        // Sources that cannot seek return false and are left unchanged.
+        virtual bool Seek(std::size_t offset) noexcept{
+            return false;
+        };
 };
 
 #endif
@@ -0,0 +1,31 @@
+#ifndef FILEDATASINK_H
+#define FILEDATASINK_H
+
+#include "DataSink.h"
+#include <string>
+
+class CFileDataSink : public CDataSink{
+    private:
+        int DFileDescriptor;
+        char *DBuffer;
+        std::size_t DCapacity;
+        std::size_t DLength;
+        bool DDurable;
+
+        bool Append(const char *data, std::size_t length) noexcept;
+    public:
+        CFileDataSink(const std::string &filename, bool durable = false, std::size_t buffersize = 1024 * 1024);
+        ~CFileDataSink();
+
+        bool IsOpen() const noexcept;
+        bool Flush() noexcept;
+        bool Close() noexcept;
+
+        using CDataSink::Write;
+        bool Put(const char &ch) noexcept override;
+        bool Write(const std::vector<char> &buf) noexcept override;
+        bool Write(const char *data, std::size_t length) noexcept override;
+        bool WriteV(const std::string_view *segments, std::size_t count) noexcept override;
+};
+
+#endif
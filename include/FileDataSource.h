@@ -0,0 +1,43 @@
+#ifndef FILEDATASOURCE_H
+#define FILEDATASOURCE_H
+
+#include "DataSource.h"
+#include <string>
+
+class CFileDataSource : public CDataSource{
+    private:
+        int DFileDescriptor;
+        char *DMapped;
+        std::size_t DMappedSize;
+        std::size_t DReleased;
+        // Read fallback state, refilled lazily so End() can detect end of file
+        mutable std::vector<char> DBuffer;
+        mutable const char *DData;
+        mutable std::size_t DLength;
+        mutable std::size_t DIndex;
+        mutable bool DEndOfFile;
+        // End reads ahead into this spare buffer rather than over the current
+        // one, the next fill swaps it in
+        mutable std::vector<char> DAhead;
+        mutable std::size_t DAheadLength;
+
+        bool Fill() const noexcept;
+        bool ReadAhead() const noexcept;
+        void ReleaseConsumed() noexcept;
+    public:
+        CFileDataSource(const std::string &filename, std::size_t buffersize = 64 * 1024);
+        ~CFileDataSource();
+
+        bool IsOpen() const noexcept;
+        bool IsMapped() const noexcept;
+
+        bool End() const noexcept override;
+        bool Get(char &ch) noexcept override;
+        bool Peek(char &ch) noexcept override;
+        bool Read(std::vector<char> &buf, std::size_t count) noexcept override;
+        bool PeekBlock(const char *&data, std::size_t &length) noexcept override;
+        std::size_t Consume(std::size_t count) noexcept override;
+        bool Seek(std::size_t offset) noexcept override;
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef IOURING_H
+#define IOURING_H
+
+#include <cstdint>
+#include <memory>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+// Minimal io_uring built directly on the kernel interface, covering what the
+// asynchronous file source and sink need: reads and writes at offsets, with
+// or without registered buffers. Only available when built with the kernel
+// header (HAVE_IO_URING), otherwise the ring never opens and callers fall
+// back to plain system calls.
+class CIOUring{
+    private:
+        struct SImplementation;
+        std::unique_ptr<SImplementation> DImplementation;
+
+    public:
+        CIOUring(unsigned entries);
+        ~CIOUring();
+
+        CIOUring(const CIOUring &) = delete;
+        CIOUring &operator=(const CIOUring &) = delete;
+
+        bool IsOpen() const noexcept;
+        bool RegisterBuffers(const struct iovec *vectors, unsigned count) noexcept;
+
+        // Queue a request, bufferindex is the registered buffer holding buffer
+        // or -1 for an unregistered one. Returns false when the queue is full.
+        bool PrepareRead(int fd, char *buffer, std::size_t length, off_t offset, int bufferindex, uint64_t data) noexcept;
+        bool PrepareWrite(int fd, const char *buffer, std::size_t length, off_t offset, int bufferindex, uint64_t data) noexcept;
+        // Hands the queued requests to the kernel, returns false on failure
+        bool Submit() noexcept;
+        // Blocks for the next completion, result is the byte count or -errno.
+        // Returns false if waiting itself failed.
+        bool WaitCompletion(uint64_t &data, int &result) noexcept;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef PREFETCHDATASOURCE_H
+#define PREFETCHDATASOURCE_H
+
+#include "DataSource.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Reads the wrapped source ahead on a background thread into a fixed ring of
+// blocks, so parsing overlaps with I/O. The wrapped source must not be used by
+// anything else while the prefetching source exists.
+class CPrefetchDataSource : public CDataSource{
+    private:
+        std::shared_ptr< CDataSource > DSource;
+        std::vector< std::vector<char> > DBuffers;
+        std::vector< std::size_t > DLengths;
+        mutable std::size_t DHead;
+        std::size_t DTail;
+        mutable std::size_t DIndex;
+        // Shared with the background thread, guarded by DMutex
+        mutable std::mutex DMutex;
+        mutable std::condition_variable DFilledCondition;
+        mutable std::condition_variable DFreeCondition;
+        mutable std::size_t DFilled;
+        mutable bool DHolding;
+        bool DSourceDone;
+        bool DStop;
+        std::thread DThread;
+
+        void Prefetch() noexcept;
+        bool Fill() const noexcept;
+        void Release() const noexcept;
+    public:
+        CPrefetchDataSource(std::shared_ptr< CDataSource > src, std::size_t blocksize = 1024 * 1024, std::size_t blockcount = 3);
+        ~CPrefetchDataSource();
+
+        bool End() const noexcept override;
+        bool Get(char &ch) noexcept override;
+        bool Peek(char &ch) noexcept override;
+        bool Read(std::vector<char> &buf, std::size_t count) noexcept override;
+        bool PeekBlock(const char *&data, std::size_t &length) noexcept override;
+        std::size_t Consume(std::size_t count) noexcept override;
+};
+
+#endif
@@ -11,8 +11,11 @@ class CStringDataSink : public CDataSink{
         CStringDataSink() noexcept;
         const std::string &String() const;
 
+        using CDataSink::Write;
         bool Put(const char &ch) noexcept override;
         bool Write(const std::vector<char> &buf) noexcept override;
+        bool Write(const char *data, std::size_t length) noexcept override;
+        bool WriteV(const std::string_view *segments, std::size_t count) noexcept override;
 };
 
 #endif
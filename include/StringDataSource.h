@@ -3,18 +3,30 @@
 
 #include "DataSource.h"
 #include <string>
+#include <string_view>
 
 class CStringDataSource : public CDataSource{
     private:
         std::string DString;
+        // Bytes being read, either DString or memory borrowed from the caller
+        std::string_view DView;
         size_t DIndex;
     public:
         CStringDataSource(const std::string &str);
+        CStringDataSource(const char *str);
+        CStringDataSource(std::string &&str) noexcept;
+        // Borrows the bytes, the caller keeps them alive while they are read
+        CStringDataSource(std::string_view view) noexcept;
+        CStringDataSource(const CStringDataSource &) = delete;
+        CStringDataSource &operator=(const CStringDataSource &) = delete;
 
         bool End() const noexcept override;
         bool Get(char &ch) noexcept override;
         bool Peek(char &ch) noexcept override;
         bool Read(std::vector<char> &buf, std::size_t count) noexcept override;
+        bool PeekBlock(const char *&data, std::size_t &length) noexcept override;
+        std::size_t Consume(std::size_t count) noexcept override;
+        bool Seek(std::size_t offset) noexcept override;
 };
 
 #endif
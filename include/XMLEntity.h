@@ -1,46 +1,138 @@
 #ifndef XMLENTITY_H
 #define XMLENTITY_H
 
+#include <algorithm>
+#include <cstdint>
 #include <utility>
 #include <string>
+#include <string_view>
 #include <vector>
 
 struct SXMLEntity{
     using TAttribute = std::pair< std::string, std::string >;
     enum class EType{StartElement, EndElement, CharData, CompleteElement};
+    using TNameID = uint32_t;
     EType DType;
     std::string DNameData;
     std::vector< TAttribute > DAttributes;
+    // Filled by CXMLReader with IDs from its name table (CXMLReader::Names),
+    // for the element name and each attribute name in DAttributes order. 0
+    // for character data and for entities not built by a reader.
+    TNameID DNameID = 0;
+    std::vector< TNameID > DAttributeIDs;
     
-    bool AttributeExists(const std::string &name) const{
-        for(auto &Attribute : DAttributes){
-            if(std::get<0>(Attribute) == name){
-                return true;   
+    // Positions in DAttributes sorted by name, kept for elements with more
+    // than AttributeIndexThreshold attributes so lookups are binary searches.
+    // The reader and SetAttribute keep it current, after changing DAttributes
+    // directly call IndexAttributes.
+    static constexpr std::size_t AttributeIndexThreshold = 12;
+    std::vector< uint32_t > DAttributeOrder;
+    
+    // Orders names by length first, so most compares never read the bytes
+    static int CompareNames(std::string_view left, std::string_view right) noexcept{
+        if(left.size() != right.size()){
+            return left.size() < right.size() ? -1 : 1;
+        }
+        return left.compare(right);
+    };
+    
+    void IndexAttributes(){
+        DAttributeOrder.clear();
+        if(DAttributes.size() > AttributeIndexThreshold){
+            for(uint32_t Index = 0; Index < DAttributes.size(); Index++){
+                DAttributeOrder.push_back(Index);
             }
+            std::sort(DAttributeOrder.begin(), DAttributeOrder.end(), [this](uint32_t left, uint32_t right){
+                int Compare = CompareNames(DAttributes[left].first, DAttributes[right].first);
+                return Compare < 0 || (Compare == 0 && left < right);
+            });
         }
-        return false;
     };
     
-    std::string AttributeValue(const std::string &name) const{
-        for(auto &Attribute : DAttributes){
-            if(std::get<0>(Attribute) == name){
-                return std::get<1>(Attribute);   
+    // Returns the position of the attribute in DAttributes, or
+    // DAttributes.size() if there is none
+    std::size_t FindAttribute(std::string_view name) const noexcept{
+        if(DAttributeOrder.size() == DAttributes.size()){
+            auto Found = std::lower_bound(DAttributeOrder.begin(), DAttributeOrder.end(), name, [this](uint32_t index, std::string_view value){
+                return CompareNames(DAttributes[index].first, value) < 0;
+            });
+            if(Found != DAttributeOrder.end() && DAttributes[*Found].first == name){
+                return *Found;
+            }
+            return DAttributes.size();
+        }
+        for(std::size_t Index = 0; Index < DAttributes.size(); Index++){
+            if(DAttributes[Index].first == name){
+                return Index;
             }
         }
-        return std::string();
+        return DAttributes.size();
+    };
+    
+    std::size_t FindAttribute(TNameID id) const noexcept{
+        if(id){
+            for(std::size_t Index = 0; Index < DAttributeIDs.size(); Index++){
+                if(DAttributeIDs[Index] == id){
+                    return Index;
+                }
+            }
+        }
+        return DAttributes.size();
+    };
+    
+    bool AttributeExists(const std::string &name) const{
+        return FindAttribute(std::string_view(name)) < DAttributes.size();
     };
     
+    // Integer compares only, ID 0 never matches
+    bool AttributeExists(TNameID id) const{
+        return FindAttribute(id) < DAttributes.size();
+    };
+    
+    std::string AttributeValue(const std::string &name) const{
+        return std::string(AttributeView(std::string_view(name)));
+    };
+    
+    std::string AttributeValue(TNameID id) const{
+        return std::string(AttributeView(id));
+    };
+    
+    // The value without a copy, valid until the entity is changed. Empty if
+    // the attribute does not exist.
+    std::string_view AttributeView(std::string_view name) const noexcept{
+        std::size_t Index = FindAttribute(name);
+        return Index < DAttributes.size() ? std::string_view(DAttributes[Index].second) : std::string_view();
+    };
+    
+    std::string_view AttributeView(TNameID id) const noexcept{
+        std::size_t Index = FindAttribute(id);
+        return Index < DAttributes.size() ? std::string_view(DAttributes[Index].second) : std::string_view();
+    };
+    
+    // An attribute added here gets ID 0, as its name is not in a reader's table
     bool SetAttribute(const std::string &name, const std::string &value){
         if(name.empty()){
             return false;   
         }
-        for(std::vector< TAttribute >::size_type Index = 0; Index < DAttributes.size(); Index++){
-            if(std::get<0>(DAttributes[Index]) == name){
-                DAttributes[Index] = std::make_pair(name,value);
-                return true;
-            }
+        std::size_t Index = FindAttribute(std::string_view(name));
+        if(Index < DAttributes.size()){
+            std::get<1>(DAttributes[Index]) = value;
+            return true;
         }
+        if(DAttributeIDs.size() == DAttributes.size()){
+            DAttributeIDs.push_back(0);
+        }
+        bool Indexed = DAttributeOrder.size() == DAttributes.size() && !DAttributeOrder.empty();
         DAttributes.push_back(std::make_pair(name,value));
+        if(Indexed){
+            auto Position = std::lower_bound(DAttributeOrder.begin(), DAttributeOrder.end(), name, [this](uint32_t index, std::string_view value){
+                return CompareNames(DAttributes[index].first, value) < 0;
+            });
+            DAttributeOrder.insert(Position, Index);
+        }
+        else if(DAttributes.size() > AttributeIndexThreshold){
+            IndexAttributes();
+        }
         return true;
     };
 };
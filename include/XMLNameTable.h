@@ -0,0 +1,56 @@
+#ifndef XMLNAMETABLE_H
+#define XMLNAMETABLE_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Interns element and attribute names to small integer IDs, handed out in
+// order from 1. ID 0 (NoName) is never given to a name and stands for "".
+class CXMLNameTable{
+    public:
+        using TNameID = uint32_t;
+        static constexpr TNameID NoName = 0;
+
+    private:
+        // A deque never moves its strings, so the map keys can view them
+        std::deque< std::string > DNames;
+        std::unordered_map< std::string_view, TNameID > DIDs;
+
+    public:
+        CXMLNameTable(){
+            DNames.emplace_back();
+        };
+
+        CXMLNameTable(const CXMLNameTable &) = delete;
+        CXMLNameTable &operator=(const CXMLNameTable &) = delete;
+
+        // Returns the ID of name, adding it if it is new
+        TNameID Intern(std::string_view name){
+            auto Found = DIDs.find(name);
+            if(Found != DIDs.end()){
+                return Found->second;
+            }
+            TNameID ID = DNames.size();
+            DIDs.emplace(DNames.emplace_back(name), ID);
+            return ID;
+        };
+
+        // Returns the ID of name, or NoName if it has not been interned
+        TNameID Find(std::string_view name) const{
+            auto Found = DIDs.find(name);
+            return Found == DIDs.end() ? NoName : Found->second;
+        };
+
+        const std::string &Name(TNameID id) const noexcept{
+            return id < DNames.size() ? DNames[id] : DNames[NoName];
+        };
+
+        std::size_t Size() const noexcept{
+            return DNames.size() - 1;
+        };
+};
+
+#endif
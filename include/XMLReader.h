@@ -3,6 +3,8 @@
 
 #include <memory>
 #include "XMLEntity.h"
+#include "XMLVisitor.h"
+#include "XMLNameTable.h"
 #include "DataSource.h"
 
 class CXMLReader{
@@ -11,11 +13,32 @@ class CXMLReader{
         std::unique_ptr<SImplementation> DImplementation;
         
     public:
-        CXMLReader(std::shared_ptr< CDataSource > src);
+        // Expat is fed chunksize bytes at a time, copied from the source
+        // straight into the parser's buffer
+        CXMLReader(std::shared_ptr< CDataSource > src, std::size_t chunksize = 64 * 1024);
         ~CXMLReader();
         
+        // Bounds the memory held for one document position, 0 leaves a limit
+        // off. Character data is handed on in pieces of at most maxchardata
+        // bytes, and a tag, comment or other markup longer than maxmarkup
+        // bytes, or an element whose name and attributes are, is an error.
+        // The name table is not covered, see InternNames.
+        void SetLimits(std::size_t maxchardata, std::size_t maxmarkup);
+        
+        // Off by default, as it costs a hash lookup per name. Once on,
+        // entities from ReadEntity carry name IDs and the names are added to
+        // Names() until it holds maxnames, after which new names get NoName.
+        // The table is never trimmed, so maxnames bounds its memory.
+        void InternNames(std::size_t maxnames = 4096);
+        // Element and attribute names seen so far. Interning a name before
+        // it is read gives the ID the entities will have.
+        CXMLNameTable &Names();
+        
         bool End() const;
         bool ReadEntity(SXMLEntity &entity, bool skipcdata = false);
+        // Parses the rest of the document, calling the visitor for each entity
+        // instead of queueing copies. False on a parse error.
+        bool Parse(CXMLVisitor &visitor);
 };
 
 #endif
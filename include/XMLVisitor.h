@@ -0,0 +1,22 @@
+#ifndef XMLVISITOR_H
+#define XMLVISITOR_H
+
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Receives entities pushed by CXMLReader::Parse. Names, attributes and
+// character data are borrowed from the parser and only valid during the call.
+class CXMLVisitor{
+    public:
+        using TAttribute = std::pair< std::string_view, std::string_view >;
+
+        virtual ~CXMLVisitor(){};
+        virtual void StartElement(std::string_view name, const std::vector< TAttribute > &attributes){};
+        virtual void EndElement(std::string_view name){};
+        // Character data between tags arrives in one call, text that is only
+        // whitespace is held back and joins the next run, as with ReadEntity
+        virtual void CharData(std::string_view data){};
+};
+
+#endif
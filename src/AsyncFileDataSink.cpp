@@ -0,0 +1,210 @@
+#include "AsyncFileDataSink.h"
+#include "IOUring.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+struct CAsyncFileDataSink::SImplementation{
+    struct SSlot{
+        char *DBuffer;
+        off_t DOffset;
+        std::size_t DLength;
+        bool DPending;
+    };
+
+    int DFileDescriptor;
+    bool DDurable;
+    bool DError;
+    std::size_t DBlockSize;
+    std::vector<SSlot> DSlots;
+    std::size_t DCurrent;
+    off_t DOffset;
+    std::unique_ptr<CIOUring> DRing;
+    bool DRingActive;
+    bool DRegistered;
+
+    SImplementation(const std::string &filename, bool durable, std::size_t blocksize, std::size_t depth)
+        : DFileDescriptor(-1), DDurable(durable), DError(false), DBlockSize(std::max<std::size_t>(blocksize, 1)), DCurrent(0), DOffset(0), DRingActive(false), DRegistered(false){
+        DSlots.resize(std::max<std::size_t>(depth, 1));
+        for(auto &Slot : DSlots){
+            void *Buffer = nullptr;
+            if(posix_memalign(&Buffer, 4096, DBlockSize) != 0){
+                Buffer = nullptr;
+                DError = true;
+            }
+            Slot = {static_cast<char *>(Buffer), 0, 0, false};
+        }
+        if(DError){
+            return;
+        }
+        DFileDescriptor = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(DFileDescriptor >= 0){
+            DRing = std::make_unique<CIOUring>(DSlots.size());
+            DRingActive = DRing->IsOpen();
+        }
+        if(DRingActive){
+            std::vector<struct iovec> Vectors;
+            for(auto &Slot : DSlots){
+                Vectors.push_back({Slot.DBuffer, DBlockSize});
+            }
+            DRegistered = DRing->RegisterBuffers(Vectors.data(), Vectors.size());
+        }
+    }
+
+    ~SImplementation(){
+        Close();
+        DRing.reset();
+        for(auto &Slot : DSlots){
+            free(Slot.DBuffer);
+        }
+    }
+
+    bool IsAsync() const{
+        return DRingActive;
+    }
+
+    // Synchronously writes length bytes at offset, used for the fallback and
+    // to finish short asynchronous writes
+    bool WriteAt(const char *data, std::size_t length, off_t offset){
+        while(length){
+            ssize_t Result = pwrite(DFileDescriptor, data, length, offset);
+            if(Result < 0){
+                if(errno == EINTR){
+                    continue;
+                }
+                return false;
+            }
+            data += Result;
+            length -= Result;
+            offset += Result;
+        }
+        return true;
+    }
+
+    // Blocks until the slot's write has completed
+    void Wait(std::size_t index){
+        while(DSlots[index].DPending){
+            uint64_t Data;
+            int Result;
+            if(!DRing->WaitCompletion(Data, Result)){
+                DSlots[index].DPending = false;
+                DError = true;
+                break;
+            }
+            SSlot &Completed = DSlots[Data];
+            if(Result < 0){
+                DError = true;
+            }
+            else if(static_cast<std::size_t>(Result) < Completed.DLength){
+                std::size_t Written = Result;
+                if(!WriteAt(Completed.DBuffer + Written, Completed.DLength - Written, Completed.DOffset + Written)){
+                    DError = true;
+                }
+            }
+            Completed.DPending = false;
+        }
+    }
+
+    // Writes out the current block and moves on to the next free one
+    bool Submit(){
+        SSlot &Slot = DSlots[DCurrent];
+        Slot.DOffset = DOffset;
+        DOffset += Slot.DLength;
+        // Failed submissions stay queued and go in with the next wait
+        if(DRingActive && DRing->PrepareWrite(DFileDescriptor, Slot.DBuffer, Slot.DLength, Slot.DOffset, DRegistered ? static_cast<int>(DCurrent) : -1, DCurrent)){
+            Slot.DPending = true;
+            DRing->Submit();
+        }
+        if(!Slot.DPending && !WriteAt(Slot.DBuffer, Slot.DLength, Slot.DOffset)){
+            DError = true;
+        }
+        DCurrent = (DCurrent + 1) % DSlots.size();
+        Wait(DCurrent);
+        DSlots[DCurrent].DLength = 0;
+        return !DError;
+    }
+
+    bool Append(const char *data, std::size_t length){
+        if(DFileDescriptor < 0 || DError){
+            return false;
+        }
+        while(length){
+            if(DSlots[DCurrent].DLength == DBlockSize && !Submit()){
+                return false;
+            }
+            std::size_t Length = std::min(length, DBlockSize - DSlots[DCurrent].DLength);
+            std::memcpy(DSlots[DCurrent].DBuffer + DSlots[DCurrent].DLength, data, Length);
+            DSlots[DCurrent].DLength += Length;
+            data += Length;
+            length -= Length;
+        }
+        return true;
+    }
+
+    bool Flush(){
+        if(DFileDescriptor < 0){
+            return false;
+        }
+        if(DSlots[DCurrent].DLength){
+            Submit();
+        }
+        for(std::size_t Index = 0; Index < DSlots.size(); Index++){
+            Wait(Index);
+        }
+        return !DError;
+    }
+
+    bool Close(){
+        if(DFileDescriptor < 0){
+            return false;
+        }
+        bool Success = Flush();
+        if(DDurable && fsync(DFileDescriptor) != 0){
+            Success = false;
+        }
+        if(close(DFileDescriptor) != 0){
+            Success = false;
+        }
+        DFileDescriptor = -1;
+        return Success;
+    }
+};
+
+CAsyncFileDataSink::CAsyncFileDataSink(const std::string &filename, bool durable, std::size_t blocksize, std::size_t depth){
+    DImplementation = std::make_unique<SImplementation>(filename, durable, blocksize, depth);
+}
+
+CAsyncFileDataSink::~CAsyncFileDataSink(){
+}
+
+bool CAsyncFileDataSink::IsOpen() const noexcept{
+    return DImplementation->DFileDescriptor >= 0;
+}
+
+bool CAsyncFileDataSink::IsAsync() const noexcept{
+    return DImplementation->IsAsync();
+}
+
+bool CAsyncFileDataSink::Flush() noexcept{
+    return DImplementation->Flush();
+}
+
+bool CAsyncFileDataSink::Close() noexcept{
+    return DImplementation->Close();
+}
+
+bool CAsyncFileDataSink::Put(const char &ch) noexcept{
+    return DImplementation->Append(&ch, 1);
+}
+
+bool CAsyncFileDataSink::Write(const std::vector<char> &buf) noexcept{
+    return DImplementation->Append(buf.data(), buf.size());
+}
+
+bool CAsyncFileDataSink::Write(const char *data, std::size_t length) noexcept{
+    return DImplementation->Append(data, length);
+}
@@ -0,0 +1,322 @@
+#include "AsyncFileDataSource.h"
+#include "IOUring.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+struct CAsyncFileDataSource::SImplementation{
+    struct SSlot{
+        char *DBuffer;
+        off_t DOffset;
+        std::size_t DLength;
+        int DError;
+        bool DPending;
+        // Pending in the ring rather than left for pread
+        bool DQueued;
+    };
+
+    int DFileDescriptor;
+    bool DSequential;
+    std::size_t DBlockSize;
+    std::vector<SSlot> DSlots;
+    std::size_t DHead;
+    std::size_t DIndex;
+    bool DHolding;
+    int DError;
+    off_t DNextOffset;
+    std::unique_ptr<CIOUring> DRing;
+    bool DRingActive;
+    bool DRegistered;
+
+    SImplementation(const std::string &filename, std::size_t blocksize, std::size_t depth)
+        : DFileDescriptor(-1), DSequential(false), DBlockSize(std::max<std::size_t>(blocksize, 1)), 
+          DHead(0), DIndex(0), DHolding(false), DError(0), DNextOffset(0), DRingActive(false), DRegistered(false){
+        DFileDescriptor = open(filename.c_str(), O_RDONLY);
+        if(DFileDescriptor < 0){
+            return;
+        }
+        // Regular files are read at offsets until a read returns nothing, the
+        // size at open is not trusted: /proc files report 0 and files grow
+        struct stat Stat;
+        if(fstat(DFileDescriptor, &Stat) != 0 || !S_ISREG(Stat.st_mode)){
+            // Pipes cannot be read at offsets, two blocks are read in turn so
+            // End can look at the next one while the head is still held
+            DSequential = true;
+            depth = 2;
+        }
+        DSlots.resize(std::max<std::size_t>(depth, 1));
+        for(auto &Slot : DSlots){
+            void *Buffer = nullptr;
+            if(posix_memalign(&Buffer, 4096, DBlockSize) != 0){
+                Buffer = nullptr;
+            }
+            Slot = {static_cast<char *>(Buffer), 0, 0, 0, false, false};
+            if(!Buffer){
+                close(DFileDescriptor);
+                DFileDescriptor = -1;
+            }
+        }
+        if(DFileDescriptor < 0){
+            return;
+        }
+        if(!DSequential){
+            DRing = std::make_unique<CIOUring>(DSlots.size());
+            DRingActive = DRing->IsOpen();
+        }
+        if(DRingActive){
+            std::vector<struct iovec> Vectors;
+            for(auto &Slot : DSlots){
+                Vectors.push_back({Slot.DBuffer, DBlockSize});
+            }
+            DRegistered = DRing->RegisterBuffers(Vectors.data(), Vectors.size());
+        }
+        for(std::size_t Index = 0; Index < DSlots.size(); Index++){
+            Submit(Index);
+        }
+        SubmitQueued();
+    }
+
+    ~SImplementation(){
+        Drain();
+        DRing.reset();
+        for(auto &Slot : DSlots){
+            free(Slot.DBuffer);
+        }
+        if(DFileDescriptor >= 0){
+            close(DFileDescriptor);
+        }
+    }
+
+    bool IsAsync() const{
+        return DRingActive;
+    }
+
+    // Queues a read of the next block into the slot
+    void Submit(std::size_t index){
+        SSlot &Slot = DSlots[index];
+        Slot.DOffset = DNextOffset;
+        Slot.DLength = 0;
+        Slot.DError = 0;
+        Slot.DPending = true;
+        DNextOffset += DBlockSize;
+        // A full queue cannot happen with one entry per slot, should it
+        // anyway the slot is read with pread when waited on
+        Slot.DQueued = DRingActive && DRing->PrepareRead(DFileDescriptor, Slot.DBuffer, DBlockSize, Slot.DOffset, DRegistered ? static_cast<int>(index) : -1, index);
+    }
+
+    void SubmitQueued(){
+        // Failed submissions stay queued and go in with the next wait
+        if(DRingActive){
+            DRing->Submit();
+        }
+    }
+
+    // Blocks until the slot's read has completed
+    void Wait(std::size_t index){
+        SSlot &Slot = DSlots[index];
+        while(Slot.DQueued){
+            uint64_t Data;
+            int Result;
+            if(!DRing->WaitCompletion(Data, Result)){
+                Slot.DError = errno;
+                Slot.DPending = Slot.DQueued = false;
+                break;
+            }
+            SSlot &Completed = DSlots[Data];
+            Completed.DLength = Result > 0 ? Result : 0;
+            Completed.DError = Result < 0 ? -Result : 0;
+            Completed.DPending = Completed.DQueued = false;
+        }
+        while(Slot.DPending){
+            ssize_t Result = DSequential ? read(DFileDescriptor, Slot.DBuffer, DBlockSize) : pread(DFileDescriptor, Slot.DBuffer, DBlockSize, Slot.DOffset);
+            if(Result < 0 && errno == EINTR){
+                continue;
+            }
+            Slot.DLength = Result > 0 ? Result : 0;
+            Slot.DError = Result < 0 ? errno : 0;
+            Slot.DPending = false;
+        }
+    }
+
+    void Drain(){
+        for(std::size_t Index = 0; Index < DSlots.size(); Index++){
+            // Requests in the kernel still write into the buffers
+            if(DSlots[Index].DQueued){
+                Wait(Index);
+            }
+            DSlots[Index].DPending = false;
+        }
+    }
+
+    // Releases the exhausted head block and reuses its buffer for a later read
+    void Release(){
+        SSlot &Slot = DSlots[DHead];
+        off_t Expected = Slot.DOffset + Slot.DLength;
+        DHolding = false;
+        DIndex = 0;
+        if(!DSequential && Slot.DLength < DBlockSize){
+            // Short read, the blocks in flight start at the wrong offsets. At
+            // the end of the file the next read returns nothing.
+            Drain();
+            DNextOffset = Expected;
+            DHead = 0;
+            for(std::size_t Index = 0; Index < DSlots.size(); Index++){
+                Submit(Index);
+            }
+        }
+        else{
+            Submit(DHead);
+            DHead = (DHead + 1) % DSlots.size();
+        }
+        SubmitQueued();
+    }
+
+    bool Fill(){
+        if(DFileDescriptor < 0 || DError){
+            return false;
+        }
+        if(DHolding && DIndex < DSlots[DHead].DLength){
+            return true;
+        }
+        if(DHolding){
+            Release();
+        }
+        Wait(DHead);
+        // A block found empty when it was read ahead is read again, the file
+        // may have grown since
+        if(!DSequential && !DSlots[DHead].DLength && !DSlots[DHead].DError){
+            DSlots[DHead].DPending = true;
+            Wait(DHead);
+        }
+        // A failed read ends the data, the error is kept for Error
+        DError = DSlots[DHead].DError;
+        DHolding = !DError && DSlots[DHead].DLength > 0;
+        return DHolding;
+    }
+
+    // Looks for unread bytes without releasing the head block, which views
+    // from PeekBlock may still point into
+    bool AtEnd(){
+        if(!DHolding){
+            return !Fill();
+        }
+        SSlot &Head = DSlots[DHead];
+        if(DIndex < Head.DLength){
+            return false;
+        }
+        // The next slot holds the block after the head unless the head was
+        // short, for a pipe it is the only other one and read in order
+        std::size_t NextIndex = (DHead + 1) % DSlots.size();
+        SSlot &Next = DSlots[NextIndex];
+        off_t Expected = Head.DOffset + Head.DLength;
+        if(DSequential || (NextIndex != DHead && Head.DLength == DBlockSize && Next.DOffset == Expected)){
+            Wait(NextIndex);
+            if(DSequential || Next.DError || Next.DLength){
+                return Next.DError || !Next.DLength;
+            }
+        }
+        // Otherwise, or if that block was empty when read ahead, a byte is
+        // read now to look. It is read again once the head is released.
+        char TempChar;
+        ssize_t Result;
+        do{
+            Result = pread(DFileDescriptor, &TempChar, 1, Expected);
+        }while(Result < 0 && errno == EINTR);
+        return Result <= 0;
+    }
+
+    const char *Data() const{
+        return DSlots[DHead].DBuffer + DIndex;
+    }
+
+    std::size_t Remaining() const{
+        return DSlots[DHead].DLength - DIndex;
+    }
+};
+
+CAsyncFileDataSource::CAsyncFileDataSource(const std::string &filename, std::size_t blocksize, std::size_t depth){
+    DImplementation = std::make_unique<SImplementation>(filename, blocksize, depth);
+}
+
+CAsyncFileDataSource::~CAsyncFileDataSource(){
+}
+
+bool CAsyncFileDataSource::IsOpen() const noexcept{
+    return DImplementation->DFileDescriptor >= 0;
+}
+
+bool CAsyncFileDataSource::IsAsync() const noexcept{
+    return DImplementation->IsAsync();
+}
+
+bool CAsyncFileDataSource::Error() const noexcept{
+    return DImplementation->DError != 0;
+}
+
+int CAsyncFileDataSource::ErrorNumber() const noexcept{
+    return DImplementation->DError;
+}
+
+bool CAsyncFileDataSource::End() const noexcept{
+    return DImplementation->DFileDescriptor < 0 || DImplementation->AtEnd();
+}
+
+bool CAsyncFileDataSource::Get(char &ch) noexcept{
+    if(!DImplementation->Fill()){
+        return false;
+    }
+    ch = *DImplementation->Data();
+    DImplementation->DIndex++;
+    return true;
+}
+
+bool CAsyncFileDataSource::Peek(char &ch) noexcept{
+    if(!DImplementation->Fill()){
+        return false;
+    }
+    ch = *DImplementation->Data();
+    return true;
+}
+
+bool CAsyncFileDataSource::Read(std::vector<char> &buf, std::size_t count) noexcept{
+    buf.clear();
+    try{
+        while(buf.size() < count && DImplementation->Fill()){
+            std::size_t Length = std::min(count - buf.size(), DImplementation->Remaining());
+            buf.insert(buf.end(), DImplementation->Data(), DImplementation->Data() + Length);
+            DImplementation->DIndex += Length;
+        }
+    }
+    catch(...){
+        return false;
+    }
+    return !buf.empty();
+}
+
+bool CAsyncFileDataSource::PeekBlock(const char *&data, std::size_t &length) noexcept{
+    if(!DImplementation->Fill()){
+        length = 0;
+        return false;
+    }
+    data = DImplementation->Data();
+    length = DImplementation->Remaining();
+    return true;
+}
+
+std::size_t CAsyncFileDataSource::Consume(std::size_t count) noexcept{
+    std::size_t Consumed = 0;
+    // The head block is only recycled by the next fill, keeping views valid
+    while(Consumed < count){
+        if(!(DImplementation->DHolding && DImplementation->Remaining()) && !DImplementation->Fill()){
+            break;
+        }
+        std::size_t Length = std::min(count - Consumed, DImplementation->Remaining());
+        DImplementation->DIndex += Length;
+        Consumed += Length;
+    }
+    return Consumed;
+}
@@ -0,0 +1,161 @@
+#include "CompressedDataSink.h"
+#include <algorithm>
+#include <cstring>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+struct CCompressedDataSink::SImplementation{
+    std::shared_ptr<CDataSink> DSink;
+    EFormat DFormat;
+    std::vector<char> DInput;
+    std::size_t DInputLength;
+    std::vector<char> DOutput;
+    std::size_t DOutputSize;
+    bool DOpen;
+    bool DError;
+    z_stream DZStream;
+#ifdef HAVE_ZSTD
+    ZSTD_CStream *DZstdStream;
+#endif
+
+    SImplementation(std::shared_ptr<CDataSink> sink, EFormat format, int level, std::size_t blocksize)
+        : DSink(sink), DFormat(format), DInputLength(0), DOpen(false), DError(false){
+#ifdef HAVE_ZSTD
+        DZstdStream = nullptr;
+#endif
+        DInput.resize(std::max<std::size_t>(blocksize, 1));
+        DOutputSize = std::max<std::size_t>(blocksize, 64);
+        DOutput.resize(DOutputSize);
+        if(DFormat == EFormat::Zstd){
+#ifdef HAVE_ZSTD
+            DZstdStream = ZSTD_createCStream();
+            DOpen = DZstdStream && !ZSTD_isError(ZSTD_initCStream(DZstdStream, level < 0 ? ZSTD_CLEVEL_DEFAULT : level));
+#endif
+            return;
+        }
+        std::memset(&DZStream, 0, sizeof(DZStream));
+        DOpen = deflateInit2(&DZStream, level < 0 ? Z_DEFAULT_COMPRESSION : level, Z_DEFLATED, DFormat == EFormat::Gzip ? 15 + 16 : 15, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+    }
+
+    ~SImplementation(){
+        Close();
+#ifdef HAVE_ZSTD
+        if(DZstdStream){
+            ZSTD_freeCStream(DZstdStream);
+        }
+#endif
+    }
+
+    bool WriteOutput(std::size_t length){
+        if(!length){
+            return true;
+        }
+        bool Success = DSink->Write(DOutput.data(), length);
+        if(!Success){
+            DError = true;
+        }
+        return Success;
+    }
+
+    // Compresses the staged input; mode is a zlib flush value mapped to the
+    // matching zstd directive
+    bool Compress(int mode){
+#ifdef HAVE_ZSTD
+        if(DFormat == EFormat::Zstd){
+            ZSTD_EndDirective Directive = mode == Z_FINISH ? ZSTD_e_end : mode == Z_SYNC_FLUSH ? ZSTD_e_flush : ZSTD_e_continue;
+            ZSTD_inBuffer InBuffer = {DInput.data(), DInputLength, 0};
+            std::size_t Remaining;
+            do{
+                ZSTD_outBuffer OutBuffer = {DOutput.data(), DOutputSize, 0};
+                Remaining = ZSTD_compressStream2(DZstdStream, &OutBuffer, &InBuffer, Directive);
+                if(ZSTD_isError(Remaining) || !WriteOutput(OutBuffer.pos)){
+                    DError = true;
+                    return false;
+                }
+            }while(Directive == ZSTD_e_continue ? InBuffer.pos < InBuffer.size : Remaining != 0);
+            DInputLength = 0;
+            return true;
+        }
+#endif
+        DZStream.next_in = reinterpret_cast<Bytef *>(DInput.data());
+        DZStream.avail_in = DInputLength;
+        int Result;
+        do{
+            DZStream.next_out = reinterpret_cast<Bytef *>(DOutput.data());
+            DZStream.avail_out = DOutputSize;
+            Result = deflate(&DZStream, mode);
+            if(Result == Z_STREAM_ERROR || !WriteOutput(DOutputSize - DZStream.avail_out)){
+                DError = true;
+                return false;
+            }
+        }while(DZStream.avail_out == 0 || (mode == Z_FINISH && Result != Z_STREAM_END));
+        DInputLength = 0;
+        return true;
+    }
+
+    bool Append(const char *data, std::size_t length){
+        if(!DOpen || DError){
+            return false;
+        }
+        while(length){
+            if(DInputLength == DInput.size() && !Compress(Z_NO_FLUSH)){
+                return false;
+            }
+            std::size_t Length = std::min(length, DInput.size() - DInputLength);
+            std::memcpy(DInput.data() + DInputLength, data, Length);
+            DInputLength += Length;
+            data += Length;
+            length -= Length;
+        }
+        return true;
+    }
+
+    bool Flush(){
+        return DOpen && !DError && Compress(Z_SYNC_FLUSH);
+    }
+
+    bool Close(){
+        if(!DOpen){
+            return false;
+        }
+        bool Success = !DError && Compress(Z_FINISH);
+        if(DFormat != EFormat::Zstd){
+            deflateEnd(&DZStream);
+        }
+        DOpen = false;
+        return Success;
+    }
+};
+
+CCompressedDataSink::CCompressedDataSink(std::shared_ptr< CDataSink > sink, EFormat format, int level, std::size_t blocksize){
+    DImplementation = std::make_unique<SImplementation>(sink, format, level, blocksize);
+}
+
+CCompressedDataSink::~CCompressedDataSink(){
+}
+
+bool CCompressedDataSink::IsOpen() const noexcept{
+    return DImplementation->DOpen;
+}
+
+bool CCompressedDataSink::Flush() noexcept{
+    return DImplementation->Flush();
+}
+
+bool CCompressedDataSink::Close() noexcept{
+    return DImplementation->Close();
+}
+
+bool CCompressedDataSink::Put(const char &ch) noexcept{
+    return DImplementation->Append(&ch, 1);
+}
+
+bool CCompressedDataSink::Write(const std::vector<char> &buf) noexcept{
+    return DImplementation->Append(buf.data(), buf.size());
+}
+
+bool CCompressedDataSink::Write(const char *data, std::size_t length) noexcept{
+    return DImplementation->Append(data, length);
+}
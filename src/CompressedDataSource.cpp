@@ -0,0 +1,374 @@
+#include "CompressedDataSource.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+struct CCompressedDataSource::SImplementation{
+    std::shared_ptr<CDataSource> DSource;
+    EFormat DFormat;
+    // Bytes consumed from the source to detect the format, fed first. While a
+    // zlib header is probed the bytes inflated so far are kept here as well,
+    // to be passed through if the stream turns out not to be zlib.
+    static constexpr std::size_t MagicLength = 4;
+    static constexpr std::size_t ProbeLimit = 64 * 1024;
+    std::vector<char> DPrefix;
+    std::size_t DPrefixIndex;
+    bool DProbing;
+    std::vector<char> DOutput;
+    std::size_t DOutputLength;
+    std::size_t DIndex;
+    // End decodes ahead into this spare buffer rather than over the current
+    // one, the next fill swaps it in
+    std::vector<char> DAhead;
+    std::size_t DAheadLength;
+    bool DFinished;
+    bool DError;
+    z_stream DZStream;
+    bool DZStreamActive;
+#ifdef HAVE_ZSTD
+    ZSTD_DStream *DZstdStream;
+    bool DZstdFrameDone;
+#endif
+
+    SImplementation(std::shared_ptr<CDataSource> src, std::size_t blocksize)
+        : DSource(src), DFormat(EFormat::Plain), DPrefixIndex(0), DProbing(false), DOutputLength(0), DIndex(0), 
+          DAheadLength(0), DFinished(false), DError(false), DZStreamActive(false){
+#ifdef HAVE_ZSTD
+        DZstdStream = nullptr;
+        DZstdFrameDone = false;
+#endif
+        const char *Block;
+        std::size_t Length;
+        while(DPrefix.size() < MagicLength && DSource->PeekBlock(Block, Length)){
+            Length = std::min(Length, MagicLength - DPrefix.size());
+            DPrefix.insert(DPrefix.end(), Block, Block + Length);
+            DSource->Consume(Length);
+        }
+        DFormat = Detect();
+        DProbing = DFormat == EFormat::Zlib;
+        if(DFormat == EFormat::Plain){
+            return;
+        }
+        DOutput.resize(std::max<std::size_t>(blocksize, 1));
+        DAhead.resize(DOutput.size());
+        if(DFormat == EFormat::Zstd){
+#ifdef HAVE_ZSTD
+            DZstdStream = ZSTD_createDStream();
+            if(DZstdStream && !ZSTD_isError(ZSTD_initDStream(DZstdStream))){
+                return;
+            }
+#endif
+            DError = true;
+            DFinished = true;
+            return;
+        }
+        std::memset(&DZStream, 0, sizeof(DZStream));
+        if(inflateInit2(&DZStream, DFormat == EFormat::Gzip ? 15 + 16 : 15) == Z_OK){
+            DZStreamActive = true;
+        }
+        else{
+            DError = true;
+            DFinished = true;
+        }
+    }
+
+    ~SImplementation(){
+        if(DZStreamActive){
+            inflateEnd(&DZStream);
+        }
+#ifdef HAVE_ZSTD
+        if(DZstdStream){
+            ZSTD_freeDStream(DZstdStream);
+        }
+#endif
+    }
+
+    EFormat Detect() const{
+        const unsigned char *Magic = reinterpret_cast<const unsigned char *>(DPrefix.data());
+        if(DPrefix.size() >= 2 && Magic[0] == 0x1f && Magic[1] == 0x8b){
+            return EFormat::Gzip;
+        }
+        // Deflate with at most a 32 KB window, no preset dictionary and a
+        // header check that is a multiple of 31. Text such as "x^" still
+        // passes, so the start of the stream is probed before it is trusted.
+        if(DPrefix.size() >= 2 && (Magic[0] & 0x0f) == 8 && (Magic[0] >> 4) <= 7 && !(Magic[1] & 0x20) && (Magic[0] * 256 + Magic[1]) % 31 == 0){
+            return EFormat::Zlib;
+        }
+        if(DPrefix.size() >= 4 && Magic[0] == 0x28 && Magic[1] == 0xb5 && Magic[2] == 0x2f && Magic[3] == 0xfd){
+            return EFormat::Zstd;
+        }
+        return EFormat::Plain;
+    }
+
+    bool NextInput(const char *&data, std::size_t &length){
+        if(DPrefixIndex < DPrefix.size()){
+            data = DPrefix.data() + DPrefixIndex;
+            length = DPrefix.size() - DPrefixIndex;
+            return true;
+        }
+        return DSource->PeekBlock(data, length);
+    }
+
+    void ConsumeInput(const char *data, std::size_t count){
+        if(DPrefixIndex < DPrefix.size()){
+            DPrefixIndex += count;
+            return;
+        }
+        if(DProbing){
+            try{
+                if(DPrefix.size() + count > ProbeLimit){
+                    EndProbe();
+                }
+                else{
+                    DPrefix.insert(DPrefix.end(), data, data + count);
+                    DPrefixIndex += count;
+                }
+            }
+            catch(...){
+                EndProbe();
+            }
+        }
+        DSource->Consume(count);
+    }
+
+    // The stream is trusted to be zlib from here on
+    void EndProbe(){
+        DProbing = false;
+        DPrefix.clear();
+        DPrefixIndex = 0;
+    }
+
+    // The probed header was not zlib after all, everything taken from the
+    // source so far is replayed as plain input
+    std::size_t Passthrough(){
+        DFormat = EFormat::Plain;
+        DProbing = false;
+        DPrefixIndex = 0;
+        return 0;
+    }
+
+    // Decodes the next block into output, returns its length, 0 at the end
+    // of the stream. While probing, output is only handed out once a whole
+    // block decoded without an error.
+    std::size_t Decode(std::vector<char> &output){
+        std::size_t OutputLength = 0;
+        while((!OutputLength || (DProbing && OutputLength < output.size())) && !DFinished){
+            const char *Input = nullptr;
+            std::size_t InputLength = 0;
+            bool HaveInput = NextInput(Input, InputLength);
+            if(!HaveInput){
+                InputLength = 0;
+            }
+#ifdef HAVE_ZSTD
+            if(DFormat == EFormat::Zstd){
+                ZSTD_inBuffer InBuffer = {Input, InputLength, 0};
+                ZSTD_outBuffer OutBuffer = {output.data(), output.size(), 0};
+                std::size_t Result = ZSTD_decompressStream(DZstdStream, &OutBuffer, &InBuffer);
+                ConsumeInput(Input, InBuffer.pos);
+                OutputLength = OutBuffer.pos;
+                if(ZSTD_isError(Result)){
+                    DError = true;
+                    DFinished = true;
+                }
+                else if(!HaveInput && !OutputLength){
+                    DError = !DZstdFrameDone;
+                    DFinished = true;
+                }
+                else{
+                    // A zero hint means the frame ended, anything else expects more
+                    DZstdFrameDone = Result == 0;
+                }
+                continue;
+            }
+#endif
+            InputLength = std::min<std::size_t>(InputLength, UINT_MAX);
+            DZStream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(Input));
+            DZStream.avail_in = InputLength;
+            DZStream.next_out = reinterpret_cast<Bytef *>(output.data() + OutputLength);
+            DZStream.avail_out = output.size() - OutputLength;
+            std::size_t Before = OutputLength;
+            int Result = inflate(&DZStream, Z_NO_FLUSH);
+            ConsumeInput(Input, InputLength - DZStream.avail_in);
+            OutputLength = output.size() - DZStream.avail_out;
+            if(Result == Z_STREAM_END){
+                // The checksum matched, this is zlib
+                if(DProbing){
+                    EndProbe();
+                }
+                // Concatenated gzip members continue with a reset stream
+                if(NextInput(Input, InputLength)){
+                    inflateReset(&DZStream);
+                }
+                else{
+                    DFinished = true;
+                }
+            }
+            else if(Result == Z_OK || Result == Z_BUF_ERROR){
+                if(!HaveInput && OutputLength == Before){
+                    if(OutputLength){
+                        // Truncated while probing, reported by the next call
+                        break;
+                    }
+                    if(DProbing){
+                        return Passthrough();
+                    }
+                    DError = true;
+                    DFinished = true;
+                }
+            }
+            else if(DProbing){
+                return Passthrough();
+            }
+            else{
+                DError = true;
+                DFinished = true;
+            }
+        }
+        if(DProbing && OutputLength){
+            EndProbe();
+        }
+        return OutputLength;
+    }
+
+    // Current view of decoded bytes, plain input is passed through untouched
+    bool Fill(const char *&data, std::size_t &length){
+        if(DFormat != EFormat::Plain && DIndex >= DOutputLength){
+            DIndex = 0;
+            if(DAheadLength){
+                std::swap(DOutput, DAhead);
+                DOutputLength = DAheadLength;
+                DAheadLength = 0;
+            }
+            else{
+                DOutputLength = Decode(DOutput);
+            }
+        }
+        // Decoding may have fallen back to plain input
+        if(DFormat == EFormat::Plain){
+            return NextInput(data, length);
+        }
+        if(DIndex >= DOutputLength){
+            return false;
+        }
+        data = DOutput.data() + DIndex;
+        length = DOutputLength - DIndex;
+        return true;
+    }
+
+    // Looks for more bytes without touching the block views point into
+    bool AtEnd(){
+        if(DFormat != EFormat::Plain){
+            if(DIndex < DOutputLength || DAheadLength){
+                return false;
+            }
+            DAheadLength = Decode(DAhead);
+        }
+        if(DFormat == EFormat::Plain){
+            return DPrefixIndex >= DPrefix.size() && DSource->End();
+        }
+        return !DAheadLength;
+    }
+
+    void Advance(std::size_t count){
+        if(DFormat == EFormat::Plain){
+            ConsumePlain(count);
+        }
+        else{
+            DIndex += count;
+        }
+    }
+
+    // Plain input is consumed without peeking so source views stay valid
+    std::size_t ConsumePlain(std::size_t count){
+        std::size_t Consumed = std::min(count, DPrefix.size() - DPrefixIndex);
+        DPrefixIndex += Consumed;
+        if(Consumed < count){
+            Consumed += DSource->Consume(count - Consumed);
+        }
+        return Consumed;
+    }
+};
+
+CCompressedDataSource::CCompressedDataSource(std::shared_ptr< CDataSource > src, std::size_t blocksize){
+    DImplementation = std::make_unique<SImplementation>(src, blocksize);
+}
+
+CCompressedDataSource::~CCompressedDataSource(){
+}
+
+CCompressedDataSource::EFormat CCompressedDataSource::Format() const noexcept{
+    return DImplementation->DFormat;
+}
+
+bool CCompressedDataSource::Error() const noexcept{
+    return DImplementation->DError;
+}
+
+bool CCompressedDataSource::End() const noexcept{
+    return DImplementation->AtEnd();
+}
+
+bool CCompressedDataSource::Get(char &ch) noexcept{
+    const char *Data;
+    std::size_t Length;
+    if(!DImplementation->Fill(Data, Length)){
+        return false;
+    }
+    ch = *Data;
+    DImplementation->Advance(1);
+    return true;
+}
+
+bool CCompressedDataSource::Peek(char &ch) noexcept{
+    const char *Data;
+    std::size_t Length;
+    if(!DImplementation->Fill(Data, Length)){
+        return false;
+    }
+    ch = *Data;
+    return true;
+}
+
+bool CCompressedDataSource::Read(std::vector<char> &buf, std::size_t count) noexcept{
+    const char *Data;
+    std::size_t Length;
+    buf.clear();
+    try{
+        while(buf.size() < count && DImplementation->Fill(Data, Length)){
+            Length = std::min(count - buf.size(), Length);
+            buf.insert(buf.end(), Data, Data + Length);
+            DImplementation->Advance(Length);
+        }
+    }
+    catch(...){
+        return false;
+    }
+    return !buf.empty();
+}
+
+bool CCompressedDataSource::PeekBlock(const char *&data, std::size_t &length) noexcept{
+    if(!DImplementation->Fill(data, length)){
+        length = 0;
+        return false;
+    }
+    return true;
+}
+
+std::size_t CCompressedDataSource::Consume(std::size_t count) noexcept{
+    const char *Data;
+    std::size_t Length;
+    std::size_t Consumed = 0;
+    if(DImplementation->DFormat == EFormat::Plain){
+        return DImplementation->ConsumePlain(count);
+    }
+    while(Consumed < count && DImplementation->Fill(Data, Length)){
+        Length = std::min(count - Consumed, Length);
+        DImplementation->Advance(Length);
+        Consumed += Length;
+    }
+    return Consumed;
+}
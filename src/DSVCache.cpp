@@ -0,0 +1,557 @@
+#include "DSVCache.h"
+#include "DSVReader.h"
+#include "FileDataSource.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <unordered_map>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Cache layout, all fields native endian 64-bit words:
+//   header:    magic, source size, source mtime (ns), delimiter, row count,
+//              column count, body size, checksum of the body
+//   body:      field count of every row as uint32, padded to 8 bytes
+//              column sections, each starting on an 8 byte boundary
+//              column directory, six words per column, ending the body
+// The directory comes last so the body can be written as it is encoded.
+// Directory entries give the column type, the body offsets of its values
+// (int64 values or uint32 dictionary codes), its uint64 string offsets and its
+// bytes, and the number of string offsets and bytes.
+static const char CacheMagic[] = {'D', 'S', 'V', 'C', 'A', 'C', 'H', '2'};
+
+enum class EColumnType : std::uint64_t {Int64, String, Dictionary};
+
+struct SCacheHeader{
+    char DMagic[8];
+    std::uint64_t DSourceSize;
+    std::uint64_t DSourceModified;
+    std::uint64_t DDelimiter;
+    std::uint64_t DRowCount;
+    std::uint64_t DColumnCount;
+    std::uint64_t DBodySize;
+    std::uint64_t DChecksum;
+};
+
+struct SCacheColumn{
+    std::uint64_t DType;
+    std::uint64_t DValues;
+    std::uint64_t DOffsets;
+    std::uint64_t DOffsetCount;
+    std::uint64_t DBytes;
+    std::uint64_t DByteCount;
+};
+
+static bool SourceStat(const std::string &filename, std::uint64_t &size, std::uint64_t &modified){
+    struct stat Stat;
+    if(stat(filename.c_str(), &Stat) != 0 || !S_ISREG(Stat.st_mode)){
+        return false;
+    }
+    size = Stat.st_size;
+#ifdef __APPLE__
+    modified = std::uint64_t(Stat.st_mtimespec.tv_sec) * 1000000000ULL + Stat.st_mtimespec.tv_nsec;
+#else
+    modified = std::uint64_t(Stat.st_mtim.tv_sec) * 1000000000ULL + Stat.st_mtim.tv_nsec;
+#endif
+    return true;
+}
+
+static const std::uint64_t ChecksumSeed = 14695981039346656037ULL;
+
+// FNV-1a over 64-bit words, the body is always a whole number of words. Pieces
+// of whole words can be summed in order by passing on the previous hash.
+static std::uint64_t Checksum(const char *data, std::size_t length, std::uint64_t hash = ChecksumSeed) noexcept{
+    std::uint64_t Hash = hash;
+    for(std::size_t Index = 0; Index + 8 <= length; Index += 8){
+        std::uint64_t Word;
+        std::memcpy(&Word, data + Index, 8);
+        Hash = (Hash ^ Word) * 1099511628211ULL;
+    }
+    return Hash;
+}
+
+// Only values that print back to the same text can be stored as integers
+static bool ParseInt64(std::string_view field, std::int64_t &value) noexcept{
+    auto Result = std::from_chars(field.data(), field.data() + field.size(), value);
+    if(Result.ec != std::errc() || Result.ptr != field.data() + field.size()){
+        return false;
+    }
+    char Buffer[24];
+    auto Printed = std::to_chars(Buffer, Buffer + sizeof(Buffer), value);
+    return std::string_view(Buffer, Printed.ptr - Buffer) == field;
+}
+
+static void Align(std::string &image){
+    image.resize((image.size() + 7) & ~std::size_t(7), '\0');
+}
+
+template <typename T> static void AppendValue(std::string &image, T value){
+    image.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+// Encodes a column into image, which will start at body offset base
+static void EncodeColumn(const CDSVRowBatch &batch, std::size_t column, std::uint64_t base, std::string &image, SCacheColumn &entry){
+    std::size_t RowCount = batch.RowCount();
+    bool Integers = true;
+    std::int64_t Value;
+    for(std::size_t Row = 0; Row < RowCount && Integers; Row++){
+        if(column < batch.FieldCount(Row)){
+            Integers = ParseInt64(batch.Field(Row, column), Value);
+        }
+    }
+    entry = {std::uint64_t(EColumnType::Int64), 0, 0, 0, 0, 0};
+    if(Integers){
+        entry.DValues = base + image.size();
+        for(std::size_t Row = 0; Row < RowCount; Row++){
+            AppendValue<std::int64_t>(image, column < batch.FieldCount(Row) && ParseInt64(batch.Field(Row, column), Value) ? Value : 0);
+        }
+        return;
+    }
+
+    // Dictionary encode when values repeat on average, fields missing from
+    // short rows read back as empty strings. Columns that are mostly distinct
+    // in their first rows are given up on early.
+    std::unordered_map<std::string_view, std::uint32_t> Codes;
+    std::vector<std::string_view> Values;
+    std::vector<std::uint32_t> RowCodes(RowCount);
+    bool Dictionary = true;
+    for(std::size_t Row = 0; Row < RowCount && Dictionary; Row++){
+        std::string_view Field = column < batch.FieldCount(Row) ? batch.Field(Row, column) : std::string_view();
+        auto Inserted = Codes.emplace(Field, std::uint32_t(Values.size()));
+        if(Inserted.second){
+            Values.push_back(Field);
+            Dictionary = Values.size() * 2 <= RowCount && (Row < 65536 || Values.size() * 2 <= Row);
+        }
+        RowCodes[Row] = Inserted.first->second;
+    }
+    if(Dictionary){
+        entry.DType = std::uint64_t(EColumnType::Dictionary);
+        entry.DValues = base + image.size();
+        image.append(reinterpret_cast<const char *>(RowCodes.data()), RowCodes.size() * sizeof(std::uint32_t));
+        Align(image);
+    }
+    else{
+        entry.DType = std::uint64_t(EColumnType::String);
+        Values.clear();
+        for(std::size_t Row = 0; Row < RowCount; Row++){
+            Values.push_back(column < batch.FieldCount(Row) ? batch.Field(Row, column) : std::string_view());
+        }
+    }
+    entry.DOffsets = base + image.size();
+    entry.DOffsetCount = Values.size() + 1;
+    std::uint64_t Offset = 0;
+    AppendValue<std::uint64_t>(image, Offset);
+    for(auto &Field : Values){
+        Offset += Field.size();
+        AppendValue<std::uint64_t>(image, Offset);
+    }
+    entry.DBytes = base + image.size();
+    entry.DByteCount = Offset;
+    for(auto &Field : Values){
+        image.append(Field.data(), Field.size());
+    }
+    Align(image);
+}
+
+// Receives a cache image as it is built: the body in pieces of whole words,
+// then the header once the body and its checksum are known
+class CImageOutput{
+    public:
+        virtual ~CImageOutput(){};
+        virtual bool Append(const char *data, std::size_t length) = 0;
+        virtual bool Finish(const SCacheHeader &header) = 0;
+};
+
+// Keeps the image in memory, words keep it aligned
+class CMemoryImage : public CImageOutput{
+    public:
+        std::vector<std::uint64_t> DWords;
+
+        CMemoryImage() : DWords(sizeof(SCacheHeader) / 8){};
+
+        bool Append(const char *data, std::size_t length) override{
+            std::size_t Size = DWords.size();
+            DWords.resize(Size + length / 8);
+            std::memcpy(DWords.data() + Size, data, length);
+            return true;
+        };
+
+        bool Finish(const SCacheHeader &header) override{
+            std::memcpy(DWords.data(), &header, sizeof(header));
+            return true;
+        };
+};
+
+// Writes to a unique temporary file next to the cache and renames it into
+// place, so readers never see a partial file and concurrent builds of the
+// same cache do not share a temporary file
+class CFileImage : public CImageOutput{
+    private:
+        std::string DCacheFilename;
+        std::string DTempFilename;
+        int DFileDescriptor;
+        off_t DSize;
+
+        bool WriteAll(const char *data, std::size_t length, off_t offset) noexcept{
+            while(length){
+                ssize_t Result = pwrite(DFileDescriptor, data, length, offset);
+                if(Result < 0){
+                    if(errno == EINTR){
+                        continue;
+                    }
+                    return false;
+                }
+                data += Result;
+                length -= Result;
+                offset += Result;
+            }
+            return true;
+        };
+
+    public:
+        CFileImage(const std::string &cachefilename) : DCacheFilename(cachefilename), DTempFilename(cachefilename + ".XXXXXX"), DSize(sizeof(SCacheHeader)){
+            DFileDescriptor = mkstemp(&DTempFilename[0]);
+            if(DFileDescriptor >= 0){
+                fchmod(DFileDescriptor, 0644);
+            }
+        };
+
+        ~CFileImage(){
+            if(DFileDescriptor >= 0){
+                close(DFileDescriptor);
+                std::remove(DTempFilename.c_str());
+            }
+        };
+
+        bool IsOpen() const noexcept{
+            return DFileDescriptor >= 0;
+        };
+
+        bool Append(const char *data, std::size_t length) override{
+            if(!WriteAll(data, length, DSize)){
+                return false;
+            }
+            DSize += length;
+            return true;
+        };
+
+        bool Finish(const SCacheHeader &header) override{
+            bool Written = WriteAll(reinterpret_cast<const char *>(&header), sizeof(header), 0);
+            Written = close(DFileDescriptor) == 0 && Written;
+            DFileDescriptor = -1;
+            if(!Written || std::rename(DTempFilename.c_str(), DCacheFilename.c_str()) != 0){
+                std::remove(DTempFilename.c_str());
+                return false;
+            }
+            return true;
+        };
+};
+
+// Builds the cache image from the DSV file. The parsed rows are held in
+// memory, but only one column is encoded at a time.
+static bool BuildImage(const std::string &filename, char delimiter, CImageOutput &output){
+    std::uint64_t SourceSize, SourceModified;
+    // The stat is taken first, so a file changed while it is read goes stale
+    if(!SourceStat(filename, SourceSize, SourceModified)){
+        return false;
+    }
+    auto Source = std::make_shared<CFileDataSource>(filename);
+    if(!Source->IsOpen()){
+        return false;
+    }
+    CDSVReader Reader(Source, delimiter);
+    CDSVRowBatch Batch;
+    Reader.ReadRows(Batch, std::size_t(-1));
+
+    std::size_t RowCount = Batch.RowCount();
+    std::size_t ColumnCount = 0;
+    for(std::size_t Row = 0; Row < RowCount; Row++){
+        ColumnCount = std::max(ColumnCount, Batch.FieldCount(Row));
+    }
+    std::uint64_t Hash = ChecksumSeed;
+    std::uint64_t BodySize = 0;
+    auto Append = [&](const std::string &section){
+        Hash = Checksum(section.data(), section.size(), Hash);
+        BodySize += section.size();
+        return output.Append(section.data(), section.size());
+    };
+    std::string Section;
+    Section.reserve(RowCount * sizeof(std::uint32_t) + 8);
+    for(std::size_t Row = 0; Row < RowCount; Row++){
+        AppendValue<std::uint32_t>(Section, std::uint32_t(Batch.FieldCount(Row)));
+    }
+    Align(Section);
+    if(!Append(Section)){
+        return false;
+    }
+    std::string Directory(ColumnCount * sizeof(SCacheColumn), '\0');
+    for(std::size_t Column = 0; Column < ColumnCount; Column++){
+        SCacheColumn Entry;
+        Section.clear();
+        EncodeColumn(Batch, Column, BodySize, Section, Entry);
+        std::memcpy(&Directory[Column * sizeof(SCacheColumn)], &Entry, sizeof(Entry));
+        if(!Append(Section)){
+            return false;
+        }
+    }
+    if(!Append(Directory)){
+        return false;
+    }
+
+    SCacheHeader Header;
+    std::memcpy(Header.DMagic, CacheMagic, sizeof(CacheMagic));
+    Header.DSourceSize = SourceSize;
+    Header.DSourceModified = SourceModified;
+    Header.DDelimiter = static_cast<unsigned char>(delimiter);
+    Header.DRowCount = RowCount;
+    Header.DColumnCount = ColumnCount;
+    Header.DBodySize = BodySize;
+    Header.DChecksum = Hash;
+    return output.Finish(Header);
+}
+
+// Checks an image against the DSV file and that every section lies in the body
+static bool ValidImage(const char *image, std::size_t length, const std::string &filename, char delimiter){
+    SCacheHeader Header;
+    std::uint64_t SourceSize, SourceModified;
+    if(length < sizeof(Header)){
+        return false;
+    }
+    std::memcpy(&Header, image, sizeof(Header));
+    if(std::memcmp(Header.DMagic, CacheMagic, sizeof(CacheMagic)) || Header.DDelimiter != static_cast<unsigned char>(delimiter)){
+        return false;
+    }
+    if(!SourceStat(filename, SourceSize, SourceModified) || Header.DSourceSize != SourceSize || Header.DSourceModified != SourceModified){
+        return false;
+    }
+    const char *Body = image + sizeof(Header);
+    std::uint64_t BodySize = length - sizeof(Header);
+    if(Header.DBodySize != BodySize || Header.DChecksum != Checksum(Body, BodySize)){
+        return false;
+    }
+    auto Fits = [BodySize](std::uint64_t offset, std::uint64_t count, std::uint64_t size){
+        return offset % 8 == 0 && offset <= BodySize && count <= (BodySize - offset) / size;
+    };
+    std::uint64_t RowCount = Header.DRowCount;
+    if(!Fits(0, RowCount, 4) || Header.DColumnCount > BodySize / sizeof(SCacheColumn)){
+        return false;
+    }
+    std::uint64_t Directory = BodySize - Header.DColumnCount * sizeof(SCacheColumn);
+    if(Directory < RowCount * 4){
+        return false;
+    }
+    const std::uint32_t *FieldCounts = reinterpret_cast<const std::uint32_t *>(Body);
+    for(std::uint64_t Row = 0; Row < RowCount; Row++){
+        if(FieldCounts[Row] > Header.DColumnCount){
+            return false;
+        }
+    }
+    const SCacheColumn *Columns = reinterpret_cast<const SCacheColumn *>(Body + Directory);
+    for(std::uint64_t Column = 0; Column < Header.DColumnCount; Column++){
+        const SCacheColumn &Entry = Columns[Column];
+        if(Entry.DType == std::uint64_t(EColumnType::Int64)){
+            if(!Fits(Entry.DValues, RowCount, 8)){
+                return false;
+            }
+            continue;
+        }
+        bool IsDictionary = Entry.DType == std::uint64_t(EColumnType::Dictionary);
+        if(!IsDictionary && Entry.DType != std::uint64_t(EColumnType::String)){
+            return false;
+        }
+        std::uint64_t Strings = IsDictionary ? Entry.DOffsetCount - 1 : RowCount;
+        if(!Entry.DOffsetCount || Entry.DOffsetCount != Strings + 1 || !Fits(Entry.DOffsets, Entry.DOffsetCount, 8) || !Fits(Entry.DBytes, Entry.DByteCount, 1)){
+            return false;
+        }
+        const std::uint64_t *Offsets = reinterpret_cast<const std::uint64_t *>(Body + Entry.DOffsets);
+        for(std::uint64_t Index = 0; Index < Strings; Index++){
+            if(Offsets[Index] > Offsets[Index + 1]){
+                return false;
+            }
+        }
+        if(Offsets[0] != 0 || Offsets[Strings] > Entry.DByteCount){
+            return false;
+        }
+        if(IsDictionary){
+            if(!Fits(Entry.DValues, RowCount, 4)){
+                return false;
+            }
+            const std::uint32_t *Codes = reinterpret_cast<const std::uint32_t *>(Body + Entry.DValues);
+            for(std::uint64_t Row = 0; Row < RowCount; Row++){
+                if(Codes[Row] >= Strings){
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool CDSVCache::Build(const std::string &filename, char delimiter, const std::string &cachefilename){
+    CFileImage Output(cachefilename);
+    return Output.IsOpen() && BuildImage(filename, delimiter, Output);
+}
+
+bool CDSVCache::Valid(const std::string &filename, char delimiter, const std::string &cachefilename){
+    CFileDataSource Source(cachefilename);
+    const char *Data;
+    std::size_t Length;
+    return Source.IsMapped() && Source.PeekBlock(Data, Length) && ValidImage(Data, Length, filename, delimiter);
+}
+
+struct CDSVCacheReader::SImplementation {
+    struct SColumn{
+        EColumnType DType;
+        const std::int64_t *DIntegers;
+        const std::uint32_t *DCodes;
+        const std::uint64_t *DOffsets;
+        const char *DBytes;
+    };
+
+    std::shared_ptr<CFileDataSource> DCacheSource;
+    // Image built in memory when the cache cannot be mapped, words keep it aligned
+    std::vector<std::uint64_t> DOwned;
+    bool DOpen;
+    bool DFromCache;
+    std::size_t DRowCount;
+    const std::uint32_t *DFieldCounts;
+    std::vector<SColumn> DColumns;
+    std::size_t DRow;
+    std::string DScratch;
+    std::vector<std::string_view> DViews;
+
+    SImplementation(const std::string &filename, char delimiter, const std::string &cachefilename)
+        : DOpen(false), DFromCache(false), DRowCount(0), DFieldCounts(nullptr), DRow(0) {
+        DFromCache = MapCache(filename, delimiter, cachefilename);
+        if(DFromCache){
+            return;
+        }
+        if(CDSVCache::Build(filename, delimiter, cachefilename) && MapCache(filename, delimiter, cachefilename)){
+            return;
+        }
+        CMemoryImage Image;
+        if(!BuildImage(filename, delimiter, Image)){
+            return;
+        }
+        DOwned = std::move(Image.DWords);
+        Attach(reinterpret_cast<const char *>(DOwned.data()));
+    }
+
+    bool MapCache(const std::string &filename, char delimiter, const std::string &cachefilename) {
+        auto Source = std::make_shared<CFileDataSource>(cachefilename);
+        const char *Data;
+        std::size_t Length;
+        if(!Source->IsMapped() || !Source->PeekBlock(Data, Length) || !ValidImage(Data, Length, filename, delimiter)){
+            return false;
+        }
+        DCacheSource = Source;
+        Attach(Data);
+        return true;
+    }
+
+    // Points the columns into a validated image
+    void Attach(const char *image) {
+        SCacheHeader Header;
+        std::memcpy(&Header, image, sizeof(Header));
+        const char *Body = image + sizeof(Header);
+        DRowCount = Header.DRowCount;
+        DFieldCounts = reinterpret_cast<const std::uint32_t *>(Body);
+        const SCacheColumn *Entries = reinterpret_cast<const SCacheColumn *>(Body + Header.DBodySize - Header.DColumnCount * sizeof(SCacheColumn));
+        DColumns.resize(Header.DColumnCount);
+        for(std::size_t Column = 0; Column < DColumns.size(); Column++){
+            const SCacheColumn &Entry = Entries[Column];
+            DColumns[Column].DType = EColumnType(Entry.DType);
+            DColumns[Column].DIntegers = reinterpret_cast<const std::int64_t *>(Body + Entry.DValues);
+            DColumns[Column].DCodes = reinterpret_cast<const std::uint32_t *>(Body + Entry.DValues);
+            DColumns[Column].DOffsets = reinterpret_cast<const std::uint64_t *>(Body + Entry.DOffsets);
+            DColumns[Column].DBytes = Body + Entry.DBytes;
+        }
+        // Room to print an integer for every column without reallocating
+        DScratch.resize(DColumns.size() * 20);
+        DRow = 0;
+        DOpen = true;
+    }
+
+    bool ReadRowView(std::vector<std::string_view> &row) {
+        if(DRow >= DRowCount){
+            row.clear();
+            return false;
+        }
+        row.resize(DFieldCounts[DRow]);
+        char *Scratch = &DScratch[0];
+        for(std::size_t Column = 0; Column < row.size(); Column++){
+            const SColumn &Current = DColumns[Column];
+            std::size_t Index = DRow;
+            switch(Current.DType){
+                case EColumnType::Int64: {
+                    char *End = std::to_chars(Scratch, Scratch + 20, Current.DIntegers[DRow]).ptr;
+                    row[Column] = std::string_view(Scratch, End - Scratch);
+                    Scratch = End;
+                    continue;
+                }
+                case EColumnType::Dictionary:
+                    Index = Current.DCodes[DRow];
+                    break;
+                case EColumnType::String:
+                    break;
+            }
+            row[Column] = std::string_view(Current.DBytes + Current.DOffsets[Index], Current.DOffsets[Index + 1] - Current.DOffsets[Index]);
+        }
+        DRow++;
+        return true;
+    }
+
+    bool ReadRow(std::vector<std::string> &row) {
+        if(!ReadRowView(DViews)){
+            row.clear();
+            return false;
+        }
+        row.resize(DViews.size());
+        for(std::size_t Index = 0; Index < DViews.size(); Index++){
+            row[Index].assign(DViews[Index].data(), DViews[Index].size());
+        }
+        return true;
+    }
+};
+
+CDSVCacheReader::CDSVCacheReader(const std::string &filename, char delimiter, const std::string &cachefilename){
+    DImplementation = std::make_unique<SImplementation>(filename, delimiter, cachefilename);
+}
+
+CDSVCacheReader::~CDSVCacheReader(){
+}
+
+bool CDSVCacheReader::IsOpen() const noexcept{
+    return DImplementation->DOpen;
+}
+
+bool CDSVCacheReader::FromCache() const noexcept{
+    return DImplementation->DFromCache;
+}
+
+std::size_t CDSVCacheReader::RowCount() const noexcept{
+    return DImplementation->DRowCount;
+}
+
+bool CDSVCacheReader::SeekRow(std::size_t row) noexcept{
+    if(row > DImplementation->DRowCount){
+        return false;
+    }
+    DImplementation->DRow = row;
+    return true;
+}
+
+bool CDSVCacheReader::End() const noexcept{
+    return DImplementation->DRow >= DImplementation->DRowCount;
+}
+
+bool CDSVCacheReader::ReadRow(std::vector<std::string> &row){
+    return DImplementation->ReadRow(row);
+}
+
+bool CDSVCacheReader::ReadRowView(std::vector<std::string_view> &row){
+    return DImplementation->ReadRowView(row);
+}
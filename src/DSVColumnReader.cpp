@@ -0,0 +1,120 @@
+#include "DSVColumnReader.h"
+#include "DSVReader.h"
+#include <cctype>
+#include <charconv>
+
+struct CDSVColumnReader::SImplementation {
+    CDSVReader DReader;
+    std::vector<SDSVColumn::EType> DTypes;
+    std::vector<std::string_view> DRow;
+
+    SImplementation(std::shared_ptr<CDataSource> src, char delimiter, const std::vector<SDSVColumn::EType> &types)
+        : DReader(src, delimiter), DTypes(types) {
+    }
+
+    bool End() const {
+        return DReader.End();
+    }
+
+    // The whole field must convert, from_chars takes no leading space or '+'
+    template <typename T> static bool Convert(std::string_view field, T &value) {
+        auto Result = std::from_chars(field.data(), field.data() + field.size(), value);
+        return Result.ec == std::errc() && Result.ptr == field.data() + field.size();
+    }
+
+    static bool Matches(std::string_view field, const char *word) {
+        for(char ch : field){
+            if(std::tolower(static_cast<unsigned char>(ch)) != *word++){
+                return false;
+            }
+        }
+        return !*word;
+    }
+
+    static bool ConvertBool(std::string_view field, std::uint8_t &value) {
+        if(field == "1" || Matches(field, "true")){
+            value = 1;
+            return true;
+        }
+        if(field == "0" || Matches(field, "false")){
+            value = 0;
+            return true;
+        }
+        return false;
+    }
+
+    // Empties every column, clearing keeps the capacity for the next batch
+    void Clear(SDSVColumnBatch &batch) {
+        batch.DRowCount = 0;
+        batch.DColumns.resize(DTypes.size());
+        for(std::size_t Index = 0; Index < DTypes.size(); Index++){
+            SDSVColumn &Column = batch.DColumns[Index];
+            Column.DType = DTypes[Index];
+            Column.DInt64.clear();
+            Column.DDouble.clear();
+            Column.DBool.clear();
+            Column.DOffsets.assign(1, 0);
+            Column.DBytes.clear();
+            Column.DValid.clear();
+        }
+    }
+
+    // Appends a field, a missing or unconvertible field is stored as 0
+    static void Append(SDSVColumn &column, const std::string_view *field) {
+        bool Valid = false;
+        switch(column.DType){
+            case SDSVColumn::EType::Int64:{
+                std::int64_t Value = 0;
+                Valid = field && Convert(*field, Value);
+                column.DInt64.push_back(Valid ? Value : 0);
+                break;
+            }
+            case SDSVColumn::EType::Double:{
+                double Value = 0.0;
+                Valid = field && Convert(*field, Value);
+                column.DDouble.push_back(Valid ? Value : 0.0);
+                break;
+            }
+            case SDSVColumn::EType::Bool:{
+                std::uint8_t Value = 0;
+                Valid = field && ConvertBool(*field, Value);
+                column.DBool.push_back(Value);
+                break;
+            }
+            case SDSVColumn::EType::String:
+                Valid = field != nullptr;
+                if(Valid){
+                    column.DBytes.append(field->data(), field->size());
+                }
+                column.DOffsets.push_back(column.DBytes.size());
+                break;
+        }
+        column.DValid.push_back(Valid);
+    }
+
+    bool ReadBatch(SDSVColumnBatch &batch, std::size_t maxrows) {
+        Clear(batch);
+        while(batch.DRowCount < maxrows && DReader.ReadRowView(DRow)){
+            for(std::size_t Index = 0; Index < DTypes.size(); Index++){
+                Append(batch.DColumns[Index], Index < DRow.size() ? &DRow[Index] : nullptr);
+            }
+            batch.DRowCount++;
+        }
+        return batch.DRowCount > 0;
+    }
+};
+
+CDSVColumnReader::CDSVColumnReader(std::shared_ptr<CDataSource> src, char delimiter, const std::vector<SDSVColumn::EType> &types){
+    DImplementation = std::make_unique<SImplementation>(src, delimiter, types);
+}
+
+CDSVColumnReader::~CDSVColumnReader(){
+}
+
+bool CDSVColumnReader::End() const{
+    return DImplementation->End();
+}
+
+bool CDSVColumnReader::ReadBatch(SDSVColumnBatch &batch, std::size_t maxrows){
+    return DImplementation->ReadBatch(batch, maxrows);
+}
@@ -0,0 +1,119 @@
+#include "DSVHeaderReader.h"
+#include "DSVReader.h"
+#include <cstdint>
+
+struct CDSVHeaderReader::SImplementation {
+    // Open addressing table of column indices, sized to at most half full
+    struct SSlot{
+        std::uint64_t DHash;
+        std::size_t DColumn;
+    };
+
+    CDSVReader DReader;
+    std::vector<std::string> DHeader;
+    std::vector<SSlot> DSlots;
+    std::size_t DMask;
+    std::vector<std::string_view> DViews;
+
+    SImplementation(std::shared_ptr<CDataSource> src, char delimiter) : DReader(src, delimiter), DMask(0) {
+        DReader.ReadRow(DHeader);
+        std::size_t Capacity = 2;
+        while(Capacity < DHeader.size() * 2){
+            Capacity *= 2;
+        }
+        DSlots.assign(Capacity, {0, NoColumn});
+        DMask = Capacity - 1;
+        for(std::size_t Column = 0; Column < DHeader.size(); Column++){
+            std::uint64_t Hash = HashName(DHeader[Column]);
+            std::size_t Slot = Hash & DMask;
+            while(DSlots[Slot].DColumn != NoColumn){
+                if(DSlots[Slot].DHash == Hash && DHeader[DSlots[Slot].DColumn] == DHeader[Column]){
+                    break; // Duplicate names resolve to the first column
+                }
+                Slot = (Slot + 1) & DMask;
+            }
+            if(DSlots[Slot].DColumn == NoColumn){
+                DSlots[Slot] = {Hash, Column};
+            }
+        }
+    }
+
+    // FNV-1a
+    static std::uint64_t HashName(std::string_view name) noexcept {
+        std::uint64_t Hash = 14695981039346656037ULL;
+        for(char ch : name){
+            Hash = (Hash ^ static_cast<unsigned char>(ch)) * 1099511628211ULL;
+        }
+        return Hash;
+    }
+
+    std::size_t Column(std::string_view name) const noexcept {
+        std::uint64_t Hash = HashName(name);
+        for(std::size_t Slot = Hash & DMask; DSlots[Slot].DColumn != NoColumn; Slot = (Slot + 1) & DMask){
+            if(DSlots[Slot].DHash == Hash && DHeader[DSlots[Slot].DColumn] == name){
+                return DSlots[Slot].DColumn;
+            }
+        }
+        return NoColumn;
+    }
+
+    std::string_view Field(std::size_t column) const noexcept {
+        return column < DViews.size() ? DViews[column] : std::string_view();
+    }
+
+    bool ReadRowView(std::vector<std::string_view> &row) {
+        if(!DReader.ReadRowView(DViews)){
+            row.clear();
+            return false;
+        }
+        row.assign(DViews.begin(), DViews.end());
+        return true;
+    }
+
+    bool ReadRow(std::vector<std::string> &row) {
+        if(!DReader.ReadRowView(DViews)){
+            row.clear();
+            return false;
+        }
+        row.resize(DViews.size());
+        for(std::size_t Index = 0; Index < DViews.size(); Index++){
+            row[Index].assign(DViews[Index].data(), DViews[Index].size());
+        }
+        return true;
+    }
+};
+
+CDSVHeaderReader::CDSVHeaderReader(std::shared_ptr<CDataSource> src, char delimiter){
+    DImplementation = std::make_unique<SImplementation>(src, delimiter);
+}
+
+CDSVHeaderReader::~CDSVHeaderReader(){
+}
+
+const std::vector<std::string> &CDSVHeaderReader::Header() const noexcept{
+    return DImplementation->DHeader;
+}
+
+std::size_t CDSVHeaderReader::Column(std::string_view name) const noexcept{
+    return DImplementation->Column(name);
+}
+
+bool CDSVHeaderReader::End() const{
+    return DImplementation->DReader.End();
+}
+
+bool CDSVHeaderReader::ReadRow(std::vector<std::string> &row){
+    return DImplementation->ReadRow(row);
+}
+
+bool CDSVHeaderReader::ReadRowView(std::vector<std::string_view> &row){
+    return DImplementation->ReadRowView(row);
+}
+
+std::string_view CDSVHeaderReader::Field(std::size_t column) const noexcept{
+    return DImplementation->Field(column);
+}
+
+std::string_view CDSVHeaderReader::Field(std::string_view name) const noexcept{
+    return DImplementation->Field(DImplementation->Column(name));
+}
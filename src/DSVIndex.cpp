@@ -0,0 +1,278 @@
+#include "DSVIndex.h"
+#include "DSVReader.h"
+#include "DSVScan.h"
+#include <algorithm>
+#include <cstring>
+
+// Sidecar layout: magic, then varints for the interval, row count, data size
+// and number of offsets, then each offset as a varint delta from the last
+static const char IndexMagic[] = {'D', 'S', 'V', 'I', 'D', 'X', '1', '\n'};
+
+static void AppendVarint(std::string &buffer, std::uint64_t value){
+    while(value >= 0x80){
+        buffer += char((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    buffer += char(value);
+}
+
+static bool ReadVarint(CDataSource &src, std::uint64_t &value){
+    value = 0;
+    char TempChar;
+    for(int Shift = 0; Shift < 64; Shift += 7){
+        if(!src.Get(TempChar)){
+            return false;
+        }
+        value |= std::uint64_t(TempChar & 0x7F) << Shift;
+        if(!(TempChar & 0x80)){
+            return true;
+        }
+    }
+    return false;
+}
+
+CDSVIndex::CDSVIndex(std::size_t interval) : DInterval(std::max<std::size_t>(interval, 1)), DRowCount(0), DDataSize(0){
+}
+
+std::size_t CDSVIndex::Interval() const noexcept{
+    return DInterval;
+}
+
+std::size_t CDSVIndex::RowCount() const noexcept{
+    return DRowCount;
+}
+
+std::uint64_t CDSVIndex::DataSize() const noexcept{
+    return DDataSize;
+}
+
+void CDSVIndex::Build(std::shared_ptr<CDataSource> src, char delimiter){
+    DOffsets.clear();
+    DRowCount = 0;
+    DDataSize = 0;
+    delimiter = delimiter == '"' ? ',' : delimiter;
+    DSVScan::EScanState State = DSVScan::EScanState::FieldStart;
+    bool InRow = false;
+    const char *Block;
+    std::size_t Length;
+    while(src->PeekBlock(Block, Length)){
+        const char *Current = Block;
+        const char *End = Block + Length;
+        while(Current < End){
+            // A row starts wherever there is data after a row end
+            if(!InRow){
+                if(DRowCount % DInterval == 0){
+                    DOffsets.push_back(DDataSize + (Current - Block));
+                }
+                DRowCount++;
+                InRow = true;
+            }
+            const char *Next = DSVScan::NextRow(Current, End, delimiter, State);
+            if(!Next){
+                break;
+            }
+            Current = Next;
+            InRow = false;
+        }
+        DDataSize += Length;
+        src->Consume(Length);
+    }
+}
+
+bool CDSVIndex::Save(std::shared_ptr<CDataSink> sink) const{
+    std::string Buffer(IndexMagic, sizeof(IndexMagic));
+    AppendVarint(Buffer, DInterval);
+    AppendVarint(Buffer, DRowCount);
+    AppendVarint(Buffer, DDataSize);
+    AppendVarint(Buffer, DOffsets.size());
+    std::uint64_t Previous = 0;
+    for(auto Offset : DOffsets){
+        AppendVarint(Buffer, Offset - Previous);
+        Previous = Offset;
+    }
+    return sink->Write(Buffer);
+}
+
+bool CDSVIndex::Load(std::shared_ptr<CDataSource> src){
+    std::vector<char> Magic;
+    std::uint64_t Interval, RowCount, DataSize, Count;
+    if(!src->Read(Magic, sizeof(IndexMagic)) || Magic.size() != sizeof(IndexMagic) || std::memcmp(Magic.data(), IndexMagic, sizeof(IndexMagic))){
+        return false;
+    }
+    if(!ReadVarint(*src, Interval) || !ReadVarint(*src, RowCount) || !ReadVarint(*src, DataSize) || !ReadVarint(*src, Count)){
+        return false;
+    }
+    // Every interval-th row has an offset, a mismatch means a damaged file.
+    // Rounded up without adding to RowCount, which may be near its limit.
+    if(!Interval || Count != RowCount / Interval + (RowCount % Interval != 0)){
+        return false;
+    }
+    std::vector<std::uint64_t> Offsets;
+    std::uint64_t Offset = 0;
+    for(std::uint64_t Index = 0; Index < Count; Index++){
+        std::uint64_t Delta;
+        if(!ReadVarint(*src, Delta)){
+            return false;
+        }
+        Offset += Delta;
+        if(Offset > DataSize){
+            return false;
+        }
+        Offsets.push_back(Offset);
+    }
+    DInterval = Interval;
+    DRowCount = RowCount;
+    DDataSize = DataSize;
+    DOffsets = std::move(Offsets);
+    return true;
+}
+
+bool CDSVIndex::Locate(std::size_t row, std::uint64_t &offset, std::size_t &skip) const noexcept{
+    if(row > DRowCount){
+        return false;
+    }
+    if(row == DRowCount){
+        // Just past the last row
+        offset = DDataSize;
+        skip = 0;
+        return true;
+    }
+    offset = DOffsets[row / DInterval];
+    skip = row % DInterval;
+    return true;
+}
+
+struct CDSVIndexedReader::SImplementation {
+    std::shared_ptr<CDataSource> DDataSource;
+    char DDelimiter;
+    std::shared_ptr<const CDSVIndex> DIndex;
+    CDSVReader DReader;
+    std::size_t DRow;
+    // Whether the source was compared with the index yet, and the outcome
+    bool DChecked;
+    bool DMatches;
+
+    SImplementation(std::shared_ptr<CDataSource> src, char delimiter, std::shared_ptr<const CDSVIndex> index)
+        : DDataSource(src), DDelimiter(delimiter == '"' ? ',' : delimiter), DIndex(index), DReader(src, delimiter), DRow(0),
+          DChecked(false), DMatches(false) {
+    }
+
+    // A stale index, from a file that has since changed size, would seek to
+    // the wrong rows. The source must end exactly at DataSize.
+    bool CheckSize() {
+        std::uint64_t Size = DIndex->DataSize();
+        if(!DDataSource->Seek(Size) || !DDataSource->End()){
+            return false;
+        }
+        return !Size || (DDataSource->Seek(Size - 1) && !DDataSource->End());
+    }
+
+    // Indexed rows follow the newline that ended the previous row, which
+    // also catches most edits that kept the size
+    bool CheckRowStart(std::uint64_t offset) {
+        char TempChar;
+        return !offset || (DDataSource->Seek(offset - 1) && DDataSource->Get(TempChar) && TempChar == '\n');
+    }
+
+    // Skips count rows without building any fields, rows before an existing
+    // row always end with a newline
+    bool SkipRows(std::size_t count) {
+        DSVScan::EScanState State = DSVScan::EScanState::FieldStart;
+        const char *Block;
+        std::size_t Length;
+        while(count && DDataSource->PeekBlock(Block, Length)){
+            const char *Current = Block;
+            const char *End = Block + Length;
+            while(count){
+                const char *Next = DSVScan::NextRow(Current, End, DDelimiter, State);
+                if(!Next){
+                    break;
+                }
+                Current = Next;
+                count--;
+            }
+            DDataSource->Consume(count ? Length : Current - Block);
+        }
+        return count == 0;
+    }
+
+    // Puts the source back at the start of row DRow after the checks or a
+    // failed seek moved it. The index is only used while it matches the
+    // source, otherwise the rows are skipped from the start.
+    void Restore() {
+        std::uint64_t Offset;
+        std::size_t Skip;
+        if(!DMatches || !DIndex->Locate(DRow, Offset, Skip)){
+            Offset = 0;
+            Skip = DRow;
+        }
+        if(DDataSource->Seek(Offset)){
+            SkipRows(Skip);
+        }
+    }
+
+    bool SeekRow(std::size_t row) {
+        std::uint64_t Offset;
+        std::size_t Skip;
+        if((DChecked && !DMatches) || !DIndex->Locate(row, Offset, Skip)){
+            return false;
+        }
+        if(!DChecked){
+            DMatches = CheckSize();
+            DChecked = true;
+        }
+        // A row that does not follow a newline also means a stale index
+        if(DMatches && row < DIndex->RowCount() && !CheckRowStart(Offset)){
+            DMatches = false;
+        }
+        if(!DMatches || !DDataSource->Seek(Offset) || !SkipRows(Skip)){
+            Restore();
+            return false;
+        }
+        DRow = row;
+        return true;
+    }
+
+    bool ReadRowView(std::vector<std::string_view> &row) {
+        if(!DReader.ReadRowView(row)){
+            return false;
+        }
+        DRow++;
+        return true;
+    }
+
+    bool ReadRow(std::vector<std::string> &row) {
+        if(!DReader.ReadRow(row)){
+            return false;
+        }
+        DRow++;
+        return true;
+    }
+};
+
+CDSVIndexedReader::CDSVIndexedReader(std::shared_ptr<CDataSource> src, char delimiter, std::shared_ptr<const CDSVIndex> index){
+    DImplementation = std::make_unique<SImplementation>(src, delimiter, index);
+}
+
+CDSVIndexedReader::~CDSVIndexedReader(){
+}
+
+bool CDSVIndexedReader::SeekRow(std::size_t row){
+    return DImplementation->SeekRow(row);
+}
+
+std::size_t CDSVIndexedReader::Row() const{
+    return DImplementation->DRow;
+}
+
+bool CDSVIndexedReader::End() const{
+    return DImplementation->DReader.End();
+}
+
+bool CDSVIndexedReader::ReadRow(std::vector<std::string> &row){
+    return DImplementation->ReadRow(row);
+}
+
+bool CDSVIndexedReader::ReadRowView(std::vector<std::string_view> &row){
+    return DImplementation->ReadRowView(row);
+}
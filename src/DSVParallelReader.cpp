@@ -0,0 +1,416 @@
+#include "DSVParallelReader.h"
+#include "DSVReader.h"
+#include "DSVScan.h"
+#include "FileDataSource.h"
+#include "StringDataSource.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+// Largest window read from a source that is not mapped, whatever the thread
+// count, unless a single chunk is larger
+static const std::size_t MaxWindowSize = 64 * 1024 * 1024;
+
+struct CDSVParallelReader::SImplementation {
+    struct SChunk{
+        // Nominal range, DBegin is the data start or just after a newline
+        const char *DBegin;
+        const char *DEnd;
+        // Scan results for a start at a row start [0] or inside quotes [1]
+        bool DScanned[2] = {false, false};
+        bool DRescanQueued = false;
+        const char *DFirstRow[2] = {nullptr, nullptr};
+        bool DEndQuoted[2] = {false, false};
+        // Resolved rows [DRowBegin, DRowEnd), DRowBegin is null if none start here
+        bool DQuoted = false;
+        const char *DRowBegin = nullptr;
+        const char *DRowEnd = nullptr;
+        bool DParsed = false;
+        CDSVRowBatch DRows;
+    };
+
+    struct STask{
+        std::size_t DChunk;
+        bool DParse;
+        bool DQuoted;
+    };
+
+    std::shared_ptr<CDataSource> DDataSource;
+    char DDelimiter;
+    bool DOrdered;
+    std::vector<SChunk> DChunks;
+    std::size_t DWindow;
+    std::size_t DChunkSize;
+
+    // Sources that are not mapped are read a window at a time into DBuffer.
+    // The window ends at DWindowEnd, and the bytes from DCarry on are read
+    // again at the start of the next one. DFinal is set for the last window.
+    std::size_t DWindowSize;
+    std::string DBuffer;
+    const char *DWindowEnd;
+    const char *DCarry;
+    bool DFinal;
+
+    // Shared with the workers, guarded by DMutex
+    std::mutex DMutex;
+    std::condition_variable DWorkCondition;
+    std::condition_variable DReadyCondition;
+    std::deque<STask> DTasks;
+    std::deque<std::size_t> DReady;
+    std::size_t DNextScan;
+    std::size_t DInFlight;
+    std::size_t DRunning;
+    std::size_t DResolved;
+    std::size_t DLastRowChunk;
+    std::size_t DNonEmpty;
+    std::size_t DDelivered;
+    bool DWindowResolved;
+    bool DStop;
+    std::vector<std::thread> DThreads;
+
+    // Consumer side, the chunk being read and the position in it
+    std::size_t DNextOrdered;
+    SChunk *DCurrent;
+    std::size_t DRow;
+    std::vector<std::string_view> DViews;
+
+    SImplementation(std::shared_ptr<CDataSource> src, std::string_view data, char delimiter, bool ordered, std::size_t threads, std::size_t chunksize)
+        : DDataSource(src), DDelimiter(delimiter == '"' ? ',' : delimiter), DOrdered(ordered), DChunkSize(std::max<std::size_t>(chunksize, 1)),
+          DWindowSize(0), DWindowEnd(nullptr), DCarry(nullptr), DFinal(true), DNextScan(0), DInFlight(0), DRunning(0), DResolved(0), DLastRowChunk(0),
+          DNonEmpty(0), DDelivered(0), DWindowResolved(false), DStop(false), DNextOrdered(0), DCurrent(nullptr), DRow(0) {
+        if(!threads){
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        DWindow = threads * 4;
+        auto File = std::dynamic_pointer_cast<CFileDataSource>(DDataSource);
+        if(DDataSource && !(File && File->IsMapped())){
+            // A window holds about as many chunks as may be in flight, within
+            // a fixed budget
+            DWindowSize = DChunkSize >= MaxWindowSize / DWindow ? std::max(DChunkSize, MaxWindowSize) : DWindow * DChunkSize;
+            LoadWindow();
+        }
+        else{
+            // A mapped file's block covers the rest of the file and is used in place
+            const char *Block;
+            std::size_t Length;
+            if(File && File->PeekBlock(Block, Length)){
+                data = std::string_view(Block, Length);
+            }
+            Split(data);
+        }
+        Resolve();
+        for(std::size_t Index = 0; Index < threads; Index++){
+            DThreads.emplace_back([this]{ Work(); });
+        }
+    }
+
+    ~SImplementation(){
+        {
+            std::lock_guard<std::mutex> Lock(DMutex);
+            DStop = true;
+        }
+        DWorkCondition.notify_all();
+        for(auto &Thread : DThreads){
+            Thread.join();
+        }
+    }
+
+    // Reads the next window, after the bytes carried over from the last one,
+    // and splits it into chunks. A window ends at the last newline read past
+    // the carried bytes, so every window makes progress.
+    void LoadWindow() {
+        std::string Buffer;
+        if(DCarry){
+            Buffer.assign(DCarry, DBuffer.data() + DBuffer.size() - DCarry);
+        }
+        // A row longer than a window is read again with each one, so the
+        // window grows with it to keep the rereading linear overall
+        std::size_t Carried = Buffer.size();
+        std::size_t Target = Carried + std::max(DWindowSize, Carried);
+        std::size_t Newline = std::string::npos;
+        DFinal = false;
+        while(!DFinal){
+            const char *Block;
+            std::size_t Length;
+            while(Buffer.size() < Target && DDataSource->PeekBlock(Block, Length)){
+                Length = std::min(Length, Target - Buffer.size());
+                Buffer.append(Block, Length);
+                DDataSource->Consume(Length);
+            }
+            if(Buffer.size() < Target){
+                DFinal = true;
+                break;
+            }
+            Newline = Buffer.rfind('\n');
+            if(Newline != std::string::npos && Newline >= Carried){
+                break;
+            }
+            Target += DWindowSize;
+        }
+        std::size_t WindowLength = DFinal ? Buffer.size() : Newline + 1;
+        DBuffer = std::move(Buffer);
+        Split(std::string_view(DBuffer.data(), WindowLength));
+    }
+
+    // Cuts the data into chunks of about DChunkSize bytes, each ending at a newline
+    void Split(std::string_view data) {
+        const char *Begin = data.data();
+        const char *End = Begin + data.size();
+        DChunks.clear();
+        DWindowEnd = End;
+        DCarry = End;
+        while(Begin < End){
+            const char *Next = End;
+            if(std::size_t(End - Begin) > DChunkSize){
+                const char *Newline = static_cast<const char *>(std::memchr(Begin + DChunkSize - 1, '\n', End - (Begin + DChunkSize - 1)));
+                if(Newline){
+                    Next = Newline + 1;
+                }
+            }
+            SChunk Chunk;
+            Chunk.DBegin = Begin;
+            Chunk.DEnd = Next;
+            DChunks.push_back(std::move(Chunk));
+            Begin = Next;
+        }
+    }
+
+    // Called with DMutex held once the consumer has every row of a window
+    // that is not the last. Scans no longer needed may still be queued or
+    // running, they are dropped or waited for before the chunks are replaced.
+    void NextWindow(std::unique_lock<std::mutex> &lock) {
+        DTasks.clear();
+        DReadyCondition.wait(lock, [this]{ return !DRunning; });
+        lock.unlock();
+        LoadWindow();
+        lock.lock();
+        DNextScan = DResolved = DLastRowChunk = DNonEmpty = DDelivered = DNextOrdered = 0;
+        DWindowResolved = false;
+        Resolve();
+    }
+
+    // Called with DMutex held, starts scans while the window has room
+    void QueueScans() {
+        while(DNextScan < DChunks.size() && DInFlight < DWindow){
+            DTasks.push_back({DNextScan++, false, false});
+            DInFlight++;
+        }
+    }
+
+    void Work() {
+        std::unique_lock<std::mutex> Lock(DMutex);
+        while(true){
+            DWorkCondition.wait(Lock, [this]{ return DStop || !DTasks.empty(); });
+            if(DStop){
+                return;
+            }
+            STask Task = DTasks.front();
+            DTasks.pop_front();
+            DRunning++;
+            SChunk &Chunk = DChunks[Task.DChunk];
+            Lock.unlock();
+            if(Task.DParse){
+                Parse(Chunk);
+            }
+            else{
+                Chunk.DEndQuoted[Task.DQuoted] = DSVScan::ScanRows(Chunk.DBegin, Chunk.DEnd, DDelimiter, Task.DQuoted, Chunk.DFirstRow[Task.DQuoted]);
+            }
+            Lock.lock();
+            DRunning--;
+            if(Task.DParse){
+                Chunk.DParsed = true;
+                Ready(Task.DChunk);
+            }
+            else{
+                Chunk.DScanned[Task.DQuoted] = true;
+                Resolve();
+            }
+        }
+    }
+
+    // Called with DMutex held, fixes where rows start in each chunk in order.
+    // Chunks that begin inside a quoted field are rescanned from that state.
+    void Resolve() {
+        while(DResolved < DChunks.size()){
+            SChunk &Chunk = DChunks[DResolved];
+            bool Quoted = DResolved && DChunks[DResolved - 1].DEndQuoted[DChunks[DResolved - 1].DQuoted];
+            if(!Chunk.DScanned[Quoted]){
+                if(Quoted && !Chunk.DRescanQueued){
+                    Chunk.DRescanQueued = true;
+                    DTasks.push_front({DResolved, false, true});
+                }
+                break;
+            }
+            Chunk.DQuoted = Quoted;
+            const char *FirstRow = Chunk.DFirstRow[Quoted];
+            if(FirstRow && FirstRow < Chunk.DEnd){
+                if(DNonEmpty){
+                    QueueParse(DLastRowChunk, FirstRow);
+                }
+                Chunk.DRowBegin = FirstRow;
+                DLastRowChunk = DResolved;
+                DNonEmpty++;
+            }
+            else{
+                // All of it belongs to a row from an earlier chunk
+                Chunk.DParsed = true;
+                DInFlight--;
+            }
+            DResolved++;
+        }
+        if(DResolved == DChunks.size() && !DWindowResolved){
+            DWindowResolved = true;
+            bool Quoted = !DChunks.empty() && DChunks.back().DEndQuoted[DChunks.back().DQuoted];
+            if(DNonEmpty && Quoted && !DFinal){
+                // The last row runs past the window, it is read again from
+                // its start with the next window
+                SChunk &Last = DChunks[DLastRowChunk];
+                DCarry = Last.DRowBegin;
+                Last.DRowBegin = nullptr;
+                Last.DParsed = true;
+                DInFlight--;
+                DNonEmpty--;
+            }
+            else if(DNonEmpty){
+                QueueParse(DLastRowChunk, DWindowEnd);
+            }
+        }
+        QueueScans();
+        DReadyCondition.notify_all();
+        DWorkCondition.notify_all();
+    }
+
+    void QueueParse(std::size_t index, const char *rowend) {
+        DChunks[index].DRowEnd = rowend;
+        DTasks.push_front({index, true, false});
+    }
+
+    // Parses the chunk's rows with a sequential reader into one batch
+    void Parse(SChunk &chunk) {
+        std::size_t Length = chunk.DRowEnd - chunk.DRowBegin;
+        CDSVReader Reader(std::make_shared<CStringDataSource>(std::string_view(chunk.DRowBegin, Length)), DDelimiter);
+        chunk.DRows.Reserve(Length);
+        Reader.ReadRows(chunk.DRows, std::numeric_limits<std::size_t>::max());
+    }
+
+    // Called with DMutex held once a chunk has been parsed
+    void Ready(std::size_t index) {
+        if(!DOrdered){
+            DReady.push_back(index);
+        }
+        DReadyCondition.notify_all();
+    }
+
+    // Called with DMutex held, frees the chunk the consumer has finished
+    void Release() {
+        if(!DCurrent){
+            return;
+        }
+        DCurrent->DRows = CDSVRowBatch();
+        DCurrent = nullptr;
+        DInFlight--;
+        QueueScans();
+        DWorkCondition.notify_all();
+    }
+
+    bool Remaining() const {
+        return DCurrent && DRow < DCurrent->DRows.RowCount();
+    }
+
+    // Moves to the next chunk holding rows, waiting for it to be parsed
+    bool Advance() {
+        std::unique_lock<std::mutex> Lock(DMutex);
+        while(!Remaining()){
+            Release();
+            if(DOrdered){
+                while(DNextOrdered < DChunks.size()){
+                    DReadyCondition.wait(Lock, [this]{ return DNextOrdered < DResolved && DChunks[DNextOrdered].DParsed; });
+                    if(DChunks[DNextOrdered++].DRowBegin){
+                        DCurrent = &DChunks[DNextOrdered - 1];
+                        break;
+                    }
+                }
+            }
+            else{
+                DReadyCondition.wait(Lock, [this]{ return !DReady.empty() || (DResolved == DChunks.size() && DDelivered == DNonEmpty); });
+                if(!DReady.empty()){
+                    DCurrent = &DChunks[DReady.front()];
+                    DReady.pop_front();
+                }
+            }
+            if(!DCurrent){
+                if(DFinal){
+                    return false;
+                }
+                NextWindow(Lock);
+                continue;
+            }
+            DDelivered++;
+            DRow = 0;
+        }
+        return true;
+    }
+
+    bool End() {
+        if(Remaining()){
+            return false;
+        }
+        std::unique_lock<std::mutex> Lock(DMutex);
+        Release();
+        while(true){
+            DReadyCondition.wait(Lock, [this]{ return DDelivered < DNonEmpty || DWindowResolved; });
+            if(DDelivered < DNonEmpty || DFinal){
+                return DDelivered == DNonEmpty;
+            }
+            NextWindow(Lock);
+        }
+    }
+
+    bool ReadRowView(std::vector<std::string_view> &row) {
+        if(!Advance()){
+            row.clear();
+            return false;
+        }
+        DCurrent->DRows.Row(DRow++, row);
+        return true;
+    }
+
+    bool ReadRow(std::vector<std::string> &row) {
+        if(!ReadRowView(DViews)){
+            row.clear();
+            return false;
+        }
+        row.resize(DViews.size());
+        for(std::size_t Index = 0; Index < DViews.size(); Index++){
+            row[Index].assign(DViews[Index].data(), DViews[Index].size());
+        }
+        return true;
+    }
+};
+
+CDSVParallelReader::CDSVParallelReader(std::shared_ptr<CDataSource> src, char delimiter, bool ordered, std::size_t threads, std::size_t chunksize){
+    DImplementation = std::make_unique<SImplementation>(src, std::string_view(), delimiter, ordered, threads, chunksize);
+}
+
+CDSVParallelReader::CDSVParallelReader(std::string_view data, char delimiter, bool ordered, std::size_t threads, std::size_t chunksize){
+    DImplementation = std::make_unique<SImplementation>(nullptr, data, delimiter, ordered, threads, chunksize);
+}
+
+CDSVParallelReader::~CDSVParallelReader(){
+}
+
+bool CDSVParallelReader::End() const{
+    return DImplementation->End();
+}
+
+bool CDSVParallelReader::ReadRow(std::vector<std::string> &row){
+    return DImplementation->ReadRow(row);
+}
+
+bool CDSVParallelReader::ReadRowView(std::vector<std::string_view> &row){
+    return DImplementation->ReadRowView(row);
+}
@@ -0,0 +1,175 @@
+#include "DSVParallelWriter.h"
+#include "DSVWriter.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+struct CDSVParallelWriter::SImplementation {
+    struct SBatch{
+        std::vector<std::vector<std::string>> DRows;
+        std::string DOutput;
+        bool DFormatted = false;
+        bool DFailed = false;
+    };
+
+    std::shared_ptr<CDataSink> DDataSink;
+    char DDelimiter;
+    bool DQuoteAll;
+    std::size_t DWindow;
+
+    // Shared with the workers and the committer, guarded by DMutex. DPending
+    // holds batches in submission order, DTasks those still to be formatted.
+    std::mutex DMutex;
+    std::condition_variable DWorkCondition;
+    std::condition_variable DCommitCondition;
+    std::condition_variable DSpaceCondition;
+    std::deque<std::shared_ptr<SBatch>> DPending;
+    std::deque<std::shared_ptr<SBatch>> DTasks;
+    bool DFailed;
+    bool DStop;
+    std::vector<std::thread> DThreads;
+    std::thread DCommitter;
+
+    SImplementation(std::shared_ptr<CDataSink> sink, char delimiter, bool quoteall, std::size_t threads)
+        : DDataSink(sink), DDelimiter(delimiter), DQuoteAll(quoteall), DFailed(false), DStop(false) {
+        if(!threads){
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        DWindow = threads * 4;
+        for(std::size_t Index = 0; Index < threads; Index++){
+            DThreads.emplace_back([this]{ Work(); });
+        }
+        DCommitter = std::thread([this]{ Commit(); });
+    }
+
+    ~SImplementation(){
+        Flush();
+        {
+            std::lock_guard<std::mutex> Lock(DMutex);
+            DStop = true;
+        }
+        DWorkCondition.notify_all();
+        DCommitCondition.notify_all();
+        for(auto &Thread : DThreads){
+            Thread.join();
+        }
+        DCommitter.join();
+    }
+
+    // Appends to the output of the batch it is pointed at
+    class CBatchDataSink : public CDataSink{
+        public:
+            std::string *DOutput = nullptr;
+
+            using CDataSink::Write;
+            bool Put(const char &ch) noexcept override{
+                return Write(&ch, 1);
+            }
+            bool Write(const std::vector<char> &buf) noexcept override{
+                return Write(buf.data(), buf.size());
+            }
+            bool Write(const char *data, std::size_t length) noexcept override{
+                try{
+                    DOutput->append(data, length);
+                    return true;
+                }
+                catch(...){
+                    return false;
+                }
+            }
+    };
+
+    // Batches are formatted by CDSVWriter, so the bytes match a single writer
+    // given the same rows. Each worker keeps one writer, and with it one
+    // format buffer, for all its batches; the output moves into the batch.
+    void Work() {
+        auto Sink = std::make_shared<CBatchDataSink>();
+        CDSVWriter Writer(Sink, DDelimiter, DQuoteAll);
+        std::size_t Reserve = 0;
+        std::unique_lock<std::mutex> Lock(DMutex);
+        while(true){
+            DWorkCondition.wait(Lock, [this]{ return DStop || !DTasks.empty(); });
+            if(DStop){
+                return;
+            }
+            std::shared_ptr<SBatch> Batch = DTasks.front();
+            DTasks.pop_front();
+            Lock.unlock();
+            Sink->DOutput = &Batch->DOutput;
+            try{
+                // Sized like the last batch, which is usually close
+                Batch->DOutput.reserve(Reserve);
+                Batch->DFailed = !Writer.WriteRows(Batch->DRows);
+            }
+            catch(...){
+                Batch->DFailed = true;
+            }
+            Reserve = Batch->DOutput.size();
+            Batch->DRows = std::vector<std::vector<std::string>>();
+            Lock.lock();
+            Batch->DFormatted = true;
+            if(Batch == DPending.front()){
+                DCommitCondition.notify_one();
+            }
+        }
+    }
+
+    // Writes formatted batches to the sink strictly in submission order
+    void Commit() {
+        std::unique_lock<std::mutex> Lock(DMutex);
+        while(true){
+            DCommitCondition.wait(Lock, [this]{ return DStop || (!DPending.empty() && DPending.front()->DFormatted); });
+            if(DStop){
+                return;
+            }
+            std::shared_ptr<SBatch> Batch = DPending.front();
+            // Nothing more is written after a failure, so the output never has gaps
+            bool Skip = DFailed || Batch->DFailed;
+            Lock.unlock();
+            const std::string &Output = Batch->DOutput;
+            bool Written = !Skip && (Output.empty() || DDataSink->Write(Output.data(), Output.size()));
+            Batch->DOutput = std::string();
+            Lock.lock();
+            DFailed |= !Written;
+            DPending.pop_front();
+            DSpaceCondition.notify_all();
+        }
+    }
+
+    bool WriteRows(std::vector<std::vector<std::string>> rows) {
+        std::unique_lock<std::mutex> Lock(DMutex);
+        DSpaceCondition.wait(Lock, [this]{ return DPending.size() < DWindow; });
+        if(DFailed){
+            return false;
+        }
+        auto Batch = std::make_shared<SBatch>();
+        Batch->DRows = std::move(rows);
+        DPending.push_back(Batch);
+        DTasks.push_back(Batch);
+        DWorkCondition.notify_one();
+        return true;
+    }
+
+    bool Flush() {
+        std::unique_lock<std::mutex> Lock(DMutex);
+        DSpaceCondition.wait(Lock, [this]{ return DPending.empty(); });
+        return !DFailed;
+    }
+};
+
+CDSVParallelWriter::CDSVParallelWriter(std::shared_ptr<CDataSink> sink, char delimiter, bool quoteall, std::size_t threads){
+    DImplementation = std::make_unique<SImplementation>(sink, delimiter, quoteall, threads);
+}
+
+CDSVParallelWriter::~CDSVParallelWriter(){
+}
+
+bool CDSVParallelWriter::WriteRows(std::vector<std::vector<std::string>> rows){
+    return DImplementation->WriteRows(std::move(rows));
+}
+
+bool CDSVParallelWriter::Flush(){
+    return DImplementation->Flush();
+}
@@ -1,83 +1,331 @@
 #include "DSVReader.h"
+#include "DSVScan.h"
 #include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <limits>
 
 struct CDSVReader::SImplementation {
+    enum class EState{FieldStart, Unquoted, Quoted, QuotePending};
+    
+    // Field bounds relative to the start of the row data
+    struct SField{
+        size_t DBegin;
+        size_t DEnd;
+    };
+    
     std::shared_ptr<CDataSource> DDataSource;
     char DDelimiter;
+    std::vector<SField> DFields;
+    const char *DRowData;
+    // Holds the row when it spans several source blocks
+    std::string DRow;
+    // Unescaped copies of fields that contained escaped quotes, and the
+    // output index and bounds of each until DUnescaped stops growing
+    std::string DUnescaped;
+    std::vector<std::pair<size_t, SField>> DUnescapedFields;
+    std::vector<std::string_view> DViews;
+    // Fields returned when projecting, in output order
+    bool DProjected;
+    std::vector<size_t> DColumns;
+    // Fields past the last projected column are not recorded
+    size_t DFieldLimit;
+    // Row filter, DFilterColumn is max() when any field may contain the text.
+    // Rows are only prefiltered on raw bytes when escaping cannot change the
+    // text, which is when the text has no quote.
+    bool DFiltered;
+    bool DPrefiltered;
+    std::string DFilterText;
+    size_t DFilterColumn;
     
     SImplementation(std::shared_ptr<CDataSource> src, char delimiter) 
-        : DDataSource(src), DDelimiter(delimiter == '"' ? ',' : delimiter) {
+        : DDataSource(src), DDelimiter(delimiter == '"' ? ',' : delimiter), DRowData(nullptr), DProjected(false), DFieldLimit(std::numeric_limits<size_t>::max()),
+          DFiltered(false), DPrefiltered(false), DFilterColumn(std::numeric_limits<size_t>::max()) {
+    }
+    
+    SImplementation(std::shared_ptr<CDataSource> src, char delimiter, const std::vector<size_t> &columns) 
+        : SImplementation(src, delimiter) {
+        DProjected = true;
+        DColumns = columns;
+        SetFieldLimit();
+    }
+    
+    // Consumes the header row and keeps the columns with the given names
+    SImplementation(std::shared_ptr<CDataSource> src, char delimiter, const std::vector<std::string> &columns) 
+        : SImplementation(src, delimiter) {
+        ReadRowView(DViews);
+        DProjected = true;
+        for(auto &Name : columns){
+            size_t Column = 0;
+            while(Column < DViews.size() && DViews[Column] != Name){
+                Column++;
+            }
+            DColumns.push_back(Column < DViews.size() ? Column : std::numeric_limits<size_t>::max());
+        }
+        SetFieldLimit();
+    }
+    
+    void SetFieldLimit() {
+        DFieldLimit = DProjected ? 0 : std::numeric_limits<size_t>::max();
+        for(auto Column : DColumns){
+            if(Column != std::numeric_limits<size_t>::max()){
+                DFieldLimit = std::max(DFieldLimit, Column + 1);
+            }
+        }
+        // Filtered fields are recorded even when they are not returned
+        if(DFiltered){
+            DFieldLimit = DFilterColumn == std::numeric_limits<size_t>::max() ? DFilterColumn : std::max(DFieldLimit, DFilterColumn + 1);
+        }
+    }
+    
+    void SetFilter(std::string_view text, size_t column) {
+        DFiltered = true;
+        DFilterText.assign(text.data(), text.size());
+        DFilterColumn = column;
+        DPrefiltered = !text.empty() && text.find('"') == std::string_view::npos;
+        SetFieldLimit();
     }
     
     bool End() const {
         return DDataSource->End();
     }
     
-    bool ReadRow(std::vector<std::string> &row) {
-        row.clear();
+    // Consumes the rows before the next occurrence of the filter text in the
+    // source. Rows that span blocks, or whose fields have text after their
+    // closing quote, are left for a full parse.
+    void SkipRejected() {
+        const char *Block;
+        size_t Length;
+        while(DDataSource->PeekBlock(Block, Length)){
+            const char *Match = DSVScan::FindSubstring(Block, Block + Length, DFilterText.data(), DFilterText.size());
+            const char *RowStart = DSVScan::FindRowStart(Block, Match, DDelimiter);
+            DDataSource->Consume(RowStart - Block);
+            if(Match != Block + Length || RowStart == Block){
+                return;
+            }
+        }
+    }
+    
+    // Checks the filter against the unescaped fields of the parsed row
+    bool Matches() {
+        size_t First = DFilterColumn == std::numeric_limits<size_t>::max() ? 0 : DFilterColumn;
+        size_t Last = DFilterColumn == std::numeric_limits<size_t>::max() ? DFields.size() : std::min(DFilterColumn + 1, DFields.size());
+        for(size_t Field = First; Field < Last; Field++){
+            std::string_view Value(DRowData + DFields[Field].DBegin, DFields[Field].DEnd - DFields[Field].DBegin);
+            if(!Value.empty() && Value[0] == '"'){
+                DUnescaped.clear();
+                Unescape(Value);
+                Value = DUnescaped;
+            }
+            if(DFilterColumn == std::numeric_limits<size_t>::max() ? Value.find(DFilterText) != std::string_view::npos : Value == DFilterText){
+                return true;
+            }
+        }
+        // A missing column reads as empty
+        return DFilterColumn != std::numeric_limits<size_t>::max() && DFilterColumn >= DFields.size() && DFilterText.empty();
+    }
+    
+    bool ParseRow() {
+        if(!DFiltered){
+            return ParseNextRow();
+        }
+        while(true){
+            if(DPrefiltered){
+                SkipRejected();
+            }
+            if(!ParseNextRow()){
+                return false;
+            }
+            if(Matches()){
+                return true;
+            }
+        }
+    }
+    
+    // Locates the next row and the bounds of its fields. The row data is left
+    // in the source block when the row lies within one block, else in DRow.
+    bool ParseNextRow() {
+        DFields.clear();
+        DRow.clear();
+        DRowData = nullptr;
         if(DDataSource->End()){
             return false;
         }
         
-        std::string currentField;
-        bool inQuotes = false;
-        bool hasData = false;
+        EState State = EState::FieldStart;
+        size_t FieldBegin = 0;
+        bool Buffered = false;
+        bool HasData = false;
+        const char *Block;
+        size_t Length;
         
-        while(true){
-            char ch;
-            if(!DDataSource->Get(ch)){
-                if(hasData || !currentField.empty()){
-                    row.push_back(currentField);
-                    return true;
-                }
-                return hasData;
-            }
-            
-            hasData = true;
-            
-            if(ch == '"'){
-                if(inQuotes){
-                    // Check for escaped quote
-                    char nextCh;
-                    if(DDataSource->Peek(nextCh) && nextCh == '"'){
-                        DDataSource->Get(nextCh); // Consume the second quote
-                        currentField += '"'; // Only add one quote
+        while(DDataSource->PeekBlock(Block, Length)){
+            HasData = true;
+            size_t Base = DRow.size();
+            size_t Index = 0;
+            while(Index < Length){
+                switch(State){
+                    case EState::FieldStart:
+                        FieldBegin = Base + Index;
+                        if(Block[Index] == '"'){
+                            State = EState::Quoted;
+                            Index++;
+                            break;
+                        }
+                        State = EState::Unquoted;
+                        [[fallthrough]];
+                        
+                    case EState::Unquoted:{
+                        Index = DSVScan::FindStructural(Block + Index, Block + Length, DDelimiter) - Block;
+                        if(Index == Length){
+                            break;
+                        }
+                        char ch = Block[Index++];
+                        if(ch == '"'){
+                            break; // Quotes inside an unquoted field are literal
+                        }
+                        if(DFields.size() < DFieldLimit){
+                            DFields.push_back({FieldBegin, Base + Index - 1});
+                        }
+                        if(ch == '\n'){
+                            if(Buffered){
+                                DRow.append(Block, Index - 1);
+                                DRowData = DRow.data();
+                            }
+                            else{
+                                DRowData = Block;
+                            }
+                            DDataSource->Consume(Index);
+                            return true;
+                        }
+                        State = EState::FieldStart;
+                        break;
                     }
-                    else{
-                        inQuotes = false;
+                    
+                    case EState::Quoted:{
+                        const char *Next = static_cast<const char *>(std::memchr(Block + Index, '"', Length - Index));
+                        if(!Next){
+                            Index = Length;
+                            break;
+                        }
+                        Index = Next - Block + 1;
+                        State = EState::QuotePending;
+                        break;
                     }
-                }
-                else if(currentField.empty()){
-                    inQuotes = true;
-                }
-                else{
-                    currentField += ch;
+                    
+                    case EState::QuotePending:
+                        // A second quote is an escaped quote, anything else closes
+                        if(Block[Index] == '"'){
+                            State = EState::Quoted;
+                            Index++;
+                        }
+                        else{
+                            State = EState::Unquoted;
+                        }
+                        break;
                 }
             }
-            else if(ch == '\n'){
-                if(inQuotes){
-                    currentField += ch;
+            DRow.append(Block, Length);
+            Buffered = true;
+            DDataSource->Consume(Length);
+        }
+        
+        if(!HasData){
+            return false;
+        }
+        if(State == EState::FieldStart){
+            FieldBegin = DRow.size();
+        }
+        if(DFields.size() < DFieldLimit){
+            DFields.push_back({FieldBegin, DRow.size()});
+        }
+        DRowData = DRow.data();
+        return true;
+    }
+    
+    // Appends the field with its quoting removed to DUnescaped
+    void Unescape(std::string_view raw) {
+        bool inQuotes = true;
+        for(size_t Index = 1; Index < raw.size(); Index++){
+            char ch = raw[Index];
+            if(inQuotes && ch == '"'){
+                if(Index + 1 < raw.size() && raw[Index + 1] == '"'){
+                    DUnescaped += '"'; // Only add one quote
+                    Index++;
                 }
                 else{
-                    row.push_back(currentField);
-                    return true;
+                    inQuotes = false;
                 }
             }
-            else if(ch == DDelimiter){
-                if(inQuotes){
-                    currentField += ch;
-                }
-                else{
-                    row.push_back(currentField);
-                    currentField.clear();
-                }
+            else{
+                DUnescaped += ch;
+            }
+        }
+    }
+    
+    // Builds views of the parsed fields that are returned, only fields with
+    // escaped quotes or text after the closing quote are copied
+    void Views(std::vector<std::string_view> &row) {
+        size_t Count = DProjected ? DColumns.size() : DFields.size();
+        row.resize(Count);
+        DUnescaped.clear();
+        DUnescapedFields.clear();
+        for(size_t Index = 0; Index < Count; Index++){
+            size_t Field = DProjected ? DColumns[Index] : Index;
+            if(Field >= DFields.size()){
+                row[Index] = std::string_view();
+                continue;
+            }
+            std::string_view Raw(DRowData + DFields[Field].DBegin, DFields[Field].DEnd - DFields[Field].DBegin);
+            if(Raw.empty() || Raw[0] != '"'){
+                row[Index] = Raw;
+            }
+            else if(Raw.size() >= 2 && Raw.back() == '"' && !std::memchr(Raw.data() + 1, '"', Raw.size() - 2)){
+                row[Index] = Raw.substr(1, Raw.size() - 2);
             }
             else{
-                currentField += ch;
+                // Offsets for now, DUnescaped may still grow
+                size_t Begin = DUnescaped.size();
+                Unescape(Raw);
+                DUnescapedFields.push_back({Index, {Begin, DUnescaped.size()}});
             }
         }
-        
-        return false;
+        for(auto &Unescaped : DUnescapedFields){
+            row[Unescaped.first] = std::string_view(DUnescaped.data() + Unescaped.second.DBegin, Unescaped.second.DEnd - Unescaped.second.DBegin);
+        }
+    }
+    
+    bool ReadRowView(std::vector<std::string_view> &row) {
+        if(!ParseRow()){
+            row.clear();
+            return false;
+        }
+        Views(row);
+        return true;
+    }
+    
+    bool ReadRows(CDSVRowBatch &batch, size_t maxrows) {
+        batch.Clear();
+        while(batch.RowCount() < maxrows && ParseRow()){
+            Views(DViews);
+            for(auto &Field : DViews){
+                batch.AppendField(Field);
+            }
+            batch.EndRow();
+        }
+        return batch.RowCount() > 0;
+    }
+    
+    bool ReadRow(std::vector<std::string> &row) {
+        if(!ReadRowView(DViews)){
+            row.clear();
+            return false;
+        }
+        row.resize(DViews.size());
+        for(size_t Index = 0; Index < DViews.size(); Index++){
+            row[Index].assign(DViews[Index].data(), DViews[Index].size());
+        }
+        return true;
     }
 };
 
@@ -85,13 +333,37 @@ CDSVReader::CDSVReader(std::shared_ptr<CDataSource> src, char delimiter){
     DImplementation = std::make_unique<SImplementation>(src, delimiter);
 }
 
+CDSVReader::CDSVReader(std::shared_ptr<CDataSource> src, char delimiter, const std::vector<size_t> &columns){
+    DImplementation = std::make_unique<SImplementation>(src, delimiter, columns);
+}
+
+CDSVReader::CDSVReader(std::shared_ptr<CDataSource> src, char delimiter, const std::vector<std::string> &columns){
+    DImplementation = std::make_unique<SImplementation>(src, delimiter, columns);
+}
+
 CDSVReader::~CDSVReader(){
 }
 
+void CDSVReader::FilterContains(std::string_view text){
+    DImplementation->SetFilter(text, std::numeric_limits<size_t>::max());
+}
+
+void CDSVReader::FilterEquals(size_t column, std::string_view value){
+    DImplementation->SetFilter(value, column);
+}
+
 bool CDSVReader::End() const{
     return DImplementation->End();
 }
 
 bool CDSVReader::ReadRow(std::vector<std::string> &row){
     return DImplementation->ReadRow(row);
-} 
\ No newline at end of file
+}
+
+bool CDSVReader::ReadRowView(std::vector<std::string_view> &row){
+    return DImplementation->ReadRowView(row);
+}
+
+bool CDSVReader::ReadRows(CDSVRowBatch &batch, size_t maxrows){
+    return DImplementation->ReadRows(batch, maxrows);
+}
@@ -0,0 +1,323 @@
+#include "DSVScan.h"
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DSVSCAN_X86
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define DSVSCAN_NEON
+#endif
+
+namespace DSVScan{
+
+static const char *FindSubstringScalar(const char *begin, const char *end, const char *needle, std::size_t length) noexcept{
+    const char *Last = end - length;
+    while(begin <= Last){
+        begin = static_cast<const char *>(std::memchr(begin, needle[0], Last - begin + 1));
+        if(!begin){
+            return end;
+        }
+        if(!std::memcmp(begin, needle, length)){
+            return begin;
+        }
+        begin++;
+    }
+    return end;
+}
+
+static const char *FindStructuralScalar(const char *begin, const char *end, char delimiter) noexcept{
+    while(begin < end && *begin != delimiter && *begin != '"' && *begin != '\n'){
+        begin++;
+    }
+    return begin;
+}
+
+#ifdef DSVSCAN_X86
+__attribute__((target("sse2")))
+static const char *FindStructuralSSE2(const char *begin, const char *end, char delimiter) noexcept{
+    const __m128i Delimiter = _mm_set1_epi8(delimiter);
+    const __m128i Quote = _mm_set1_epi8('"');
+    const __m128i Newline = _mm_set1_epi8('\n');
+    while(end - begin >= 16){
+        __m128i Bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        __m128i Matches = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(Bytes, Delimiter), _mm_cmpeq_epi8(Bytes, Quote)), _mm_cmpeq_epi8(Bytes, Newline));
+        unsigned Mask = _mm_movemask_epi8(Matches);
+        if(Mask){
+            return begin + __builtin_ctz(Mask);
+        }
+        begin += 16;
+    }
+    return FindStructuralScalar(begin, end, delimiter);
+}
+
+__attribute__((target("avx2")))
+static const char *FindStructuralAVX2(const char *begin, const char *end, char delimiter) noexcept{
+    // Short ranges go straight to SSE2 without touching the upper registers
+    if(end - begin < 32){
+        return FindStructuralSSE2(begin, end, delimiter);
+    }
+    const __m256i Delimiter = _mm256_set1_epi8(delimiter);
+    const __m256i Quote = _mm256_set1_epi8('"');
+    const __m256i Newline = _mm256_set1_epi8('\n');
+    while(end - begin >= 32){
+        __m256i Bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+        __m256i Matches = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(Bytes, Delimiter), _mm256_cmpeq_epi8(Bytes, Quote)), _mm256_cmpeq_epi8(Bytes, Newline));
+        unsigned Mask = _mm256_movemask_epi8(Matches);
+        if(Mask){
+            return begin + __builtin_ctz(Mask);
+        }
+        begin += 32;
+    }
+    // Legacy SSE code after dirty upper registers stalls on every call
+    _mm256_zeroupper();
+    return FindStructuralSSE2(begin, end, delimiter);
+}
+
+__attribute__((target("sse2")))
+static const char *FindSubstringSSE2(const char *begin, const char *end, const char *needle, std::size_t length) noexcept{
+    const __m128i First = _mm_set1_epi8(needle[0]);
+    const __m128i Last = _mm_set1_epi8(needle[length - 1]);
+    // Both loads of a step stay within the range
+    while(end - begin >= std::ptrdiff_t(length + 15)){
+        __m128i Starts = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        __m128i Ends = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin + length - 1));
+        unsigned Mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(Starts, First), _mm_cmpeq_epi8(Ends, Last)));
+        while(Mask){
+            const char *Candidate = begin + __builtin_ctz(Mask);
+            if(!std::memcmp(Candidate + 1, needle + 1, length - 1)){
+                return Candidate;
+            }
+            Mask &= Mask - 1;
+        }
+        begin += 16;
+    }
+    return FindSubstringScalar(begin, end, needle, length);
+}
+
+__attribute__((target("avx2")))
+static const char *FindSubstringAVX2(const char *begin, const char *end, const char *needle, std::size_t length) noexcept{
+    if(end - begin < std::ptrdiff_t(length + 31)){
+        return FindSubstringSSE2(begin, end, needle, length);
+    }
+    const __m256i First = _mm256_set1_epi8(needle[0]);
+    const __m256i Last = _mm256_set1_epi8(needle[length - 1]);
+    while(end - begin >= std::ptrdiff_t(length + 31)){
+        __m256i Starts = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+        __m256i Ends = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin + length - 1));
+        unsigned Mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(Starts, First), _mm256_cmpeq_epi8(Ends, Last)));
+        while(Mask){
+            const char *Candidate = begin + __builtin_ctz(Mask);
+            if(!std::memcmp(Candidate + 1, needle + 1, length - 1)){
+                _mm256_zeroupper();
+                return Candidate;
+            }
+            Mask &= Mask - 1;
+        }
+        begin += 32;
+    }
+    _mm256_zeroupper();
+    return FindSubstringSSE2(begin, end, needle, length);
+}
+
+using TFindStructural = const char *(*)(const char *, const char *, char) noexcept;
+using TFindSubstring = const char *(*)(const char *, const char *, const char *, std::size_t) noexcept;
+
+// Picked once on first use depending on what the running CPU supports
+static TFindStructural SelectFindStructural() noexcept{
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")){
+        return FindStructuralAVX2;
+    }
+    if(__builtin_cpu_supports("sse2")){
+        return FindStructuralSSE2;
+    }
+    return FindStructuralScalar;
+}
+
+static TFindSubstring SelectFindSubstring() noexcept{
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")){
+        return FindSubstringAVX2;
+    }
+    if(__builtin_cpu_supports("sse2")){
+        return FindSubstringSSE2;
+    }
+    return FindSubstringScalar;
+}
+#endif
+
+#ifdef DSVSCAN_NEON
+static const char *FindStructuralNEON(const char *begin, const char *end, char delimiter) noexcept{
+    const uint8x16_t Delimiter = vdupq_n_u8(delimiter);
+    const uint8x16_t Quote = vdupq_n_u8('"');
+    const uint8x16_t Newline = vdupq_n_u8('\n');
+    while(end - begin >= 16){
+        uint8x16_t Bytes = vld1q_u8(reinterpret_cast<const uint8_t *>(begin));
+        uint8x16_t Matches = vorrq_u8(vorrq_u8(vceqq_u8(Bytes, Delimiter), vceqq_u8(Bytes, Quote)), vceqq_u8(Bytes, Newline));
+        // Narrow to four bits per byte so the first match is a count of zeros
+        uint64_t Mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(Matches), 4)), 0);
+        if(Mask){
+            return begin + (__builtin_ctzll(Mask) >> 2);
+        }
+        begin += 16;
+    }
+    return FindStructuralScalar(begin, end, delimiter);
+}
+
+static const char *FindSubstringNEON(const char *begin, const char *end, const char *needle, std::size_t length) noexcept{
+    const uint8x16_t First = vdupq_n_u8(needle[0]);
+    const uint8x16_t Last = vdupq_n_u8(needle[length - 1]);
+    while(end - begin >= std::ptrdiff_t(length + 15)){
+        uint8x16_t Starts = vld1q_u8(reinterpret_cast<const uint8_t *>(begin));
+        uint8x16_t Ends = vld1q_u8(reinterpret_cast<const uint8_t *>(begin + length - 1));
+        uint8x16_t Matches = vandq_u8(vceqq_u8(Starts, First), vceqq_u8(Ends, Last));
+        uint64_t Mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(Matches), 4)), 0);
+        while(Mask){
+            const char *Candidate = begin + (__builtin_ctzll(Mask) >> 2);
+            if(!std::memcmp(Candidate + 1, needle + 1, length - 1)){
+                return Candidate;
+            }
+            Mask &= ~(uint64_t(0xF) << (__builtin_ctzll(Mask) & ~3));
+        }
+        begin += 16;
+    }
+    return FindSubstringScalar(begin, end, needle, length);
+}
+#endif
+
+const char *FindStructural(const char *begin, const char *end, char delimiter) noexcept{
+#if defined(DSVSCAN_X86)
+    static const TFindStructural Implementation = SelectFindStructural();
+    return Implementation(begin, end, delimiter);
+#elif defined(DSVSCAN_NEON)
+    return FindStructuralNEON(begin, end, delimiter);
+#else
+    return FindStructuralScalar(begin, end, delimiter);
+#endif
+}
+
+const char *FindSubstring(const char *begin, const char *end, const char *needle, std::size_t length) noexcept{
+    if(!length){
+        return begin;
+    }
+    if(end - begin < std::ptrdiff_t(length)){
+        return end;
+    }
+#if defined(DSVSCAN_X86)
+    static const TFindSubstring Implementation = SelectFindSubstring();
+    return Implementation(begin, end, needle, length);
+#elif defined(DSVSCAN_NEON)
+    return FindSubstringNEON(begin, end, needle, length);
+#else
+    return FindSubstringScalar(begin, end, needle, length);
+#endif
+}
+
+// Last ch in [begin, end), or nullptr
+static const char *FindLast(const char *begin, const char *end, char ch) noexcept{
+#ifdef __GLIBC__
+    return static_cast<const char *>(memrchr(begin, ch, end - begin));
+#else
+    while(end > begin){
+        if(*--end == ch){
+            return end;
+        }
+    }
+    return nullptr;
+#endif
+}
+
+// Shared by NextRow and FindRowStart. With CheckClosing set, sets closed when
+// a closing quote is followed by more text of the field.
+template <bool CheckClosing> static const char *AdvanceRow(const char *begin, const char *end, char delimiter, EScanState &state, bool &closed) noexcept{
+    while(begin < end){
+        switch(state){
+            case EScanState::FieldStart:
+                if(*begin == '"'){
+                    state = EScanState::Quoted;
+                    begin++;
+                    break;
+                }
+                state = EScanState::Unquoted;
+                [[fallthrough]];
+
+            case EScanState::Unquoted:{
+                begin = FindStructural(begin, end, delimiter);
+                if(begin == end){
+                    break;
+                }
+                char ch = *begin++;
+                if(ch == '\n'){
+                    state = EScanState::FieldStart;
+                    return begin;
+                }
+                if(ch == delimiter){
+                    state = EScanState::FieldStart;
+                }
+                break;
+            }
+
+            case EScanState::Quoted:{
+                const char *Next = static_cast<const char *>(std::memchr(begin, '"', end - begin));
+                begin = Next ? Next + 1 : end;
+                if(Next){
+                    state = EScanState::QuotePending;
+                }
+                break;
+            }
+
+            case EScanState::QuotePending:
+                if(*begin == '"'){
+                    state = EScanState::Quoted;
+                    begin++;
+                }
+                else{
+                    if(CheckClosing && *begin != delimiter && *begin != '\n'){
+                        closed = true;
+                    }
+                    state = EScanState::Unquoted;
+                }
+                break;
+        }
+    }
+    return nullptr;
+}
+
+const char *NextRow(const char *begin, const char *end, char delimiter, EScanState &state) noexcept{
+    bool Closed;
+    return AdvanceRow<false>(begin, end, delimiter, state, Closed);
+}
+
+bool ScanRows(const char *begin, const char *end, char delimiter, bool quoted, const char *&rowstart) noexcept{
+    EScanState State = quoted ? EScanState::Quoted : EScanState::FieldStart;
+    rowstart = quoted ? nullptr : begin;
+    while(const char *Next = NextRow(begin, end, delimiter, State)){
+        if(!rowstart){
+            rowstart = Next;
+        }
+        begin = Next;
+    }
+    return State == EScanState::Quoted;
+}
+
+const char *FindRowStart(const char *begin, const char *position, char delimiter) noexcept{
+    const char *LastQuote = FindLast(begin, position, '"');
+    if(LastQuote){
+        EScanState State = EScanState::FieldStart;
+        while(true){
+            bool Closed = false;
+            const char *Next = AdvanceRow<true>(begin, position, delimiter, State, Closed);
+            if(!Next || Closed){
+                return begin;
+            }
+            begin = Next;
+            if(Next > LastQuote){
+                break;
+            }
+        }
+    }
+    const char *LastNewline = FindLast(begin, position, '\n');
+    return LastNewline ? LastNewline + 1 : begin;
+}
+
+}
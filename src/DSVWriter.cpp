@@ -1,66 +1,131 @@
 #include "DSVWriter.h"
+#include "DSVScan.h"
 #include <algorithm>
+#include <cstring>
+#include <string_view>
+
+// Batched rows are handed to the sink whenever this much output is buffered
+static const size_t WriteBlockSize = 1024 * 1024;
 
 struct CDSVWriter::SImplementation {
     std::shared_ptr<CDataSink> DDataSink;
     char DDelimiter;
     bool DQuoteAll;
+    std::vector<std::string_view> DSegments;
+    // Output buffer for WriteRows, allocated without zero filling as every
+    // byte handed to the sink is written first
+    std::unique_ptr<char[]> DBuffer;
+    size_t DCapacity;
     
     SImplementation(std::shared_ptr<CDataSink> sink, char delimiter, bool quoteall) 
-        : DDataSink(sink), DDelimiter(delimiter == '"' ? ',' : delimiter), DQuoteAll(quoteall) {
+        : DDataSink(sink), DDelimiter(delimiter == '"' ? ',' : delimiter), DQuoteAll(quoteall), DCapacity(0) {
     }
     
-    bool NeedsQuoting(const std::string &str) const {
+    // Grows the buffer to capacity, keeping its first length bytes
+    void Grow(size_t length, size_t capacity){
+        std::unique_ptr<char[]> Buffer(new char[capacity]);
+        if(length){
+            std::memcpy(Buffer.get(), DBuffer.get(), length);
+        }
+        DBuffer = std::move(Buffer);
+        DCapacity = capacity;
+    }
+    
+    // A single scan for the delimiter, quotes and newlines
+    bool NeedsQuoting(std::string_view str) const {
         if(DQuoteAll){
             return true;
         }
-        return str.find(DDelimiter) != std::string::npos || 
-               str.find('"') != std::string::npos || 
-               str.find('\n') != std::string::npos;
+        return DSVScan::FindStructural(str.data(), str.data() + str.size(), DDelimiter) != str.data() + str.size();
     }
     
-    bool WriteQuoted(const std::string &str){
-        if(!DDataSink->Put('"')){
-            return false;
+    // Adds the quoted field as segments, each quote is followed by a second one
+    void AppendQuoted(std::string_view str){
+        DSegments.push_back("\"");
+        size_t Start = 0;
+        size_t Quote;
+        while((Quote = str.find('"', Start)) != std::string_view::npos){
+            DSegments.push_back(str.substr(Start, Quote + 1 - Start));
+            DSegments.push_back("\""); // Escape quote with another quote
+            Start = Quote + 1;
         }
-        
-        for(char ch : str){
-            if(ch == '"'){
-                if(!DDataSink->Put('"')){ // Escape quote with another quote
-                    return false;
-                }
-            }
-            if(!DDataSink->Put(ch)){
-                return false;
-            }
-        }
-        
-        return DDataSink->Put('"');
+        DSegments.push_back(str.substr(Start));
+        DSegments.push_back("\"");
     }
     
+    // The whole row is handed to the sink in a single gathered write
     bool WriteRow(const std::vector<std::string> &row){
+        DSegments.clear();
         for(size_t i = 0; i < row.size(); ++i){
             if(i > 0){
-                if(!DDataSink->Put(DDelimiter)){
-                    return false;
-                }
+                DSegments.push_back(std::string_view(&DDelimiter, 1));
             }
             
             if(NeedsQuoting(row[i])){
-                if(!WriteQuoted(row[i])){
-                    return false;
-                }
+                AppendQuoted(row[i]);
             }
             else{
-                for(char ch : row[i]){
-                    if(!DDataSink->Put(ch)){
-                        return false;
-                    }
-                }
+                DSegments.push_back(row[i]);
             }
         }
+        DSegments.push_back("\n");
         
-        return DDataSink->Put('\n');
+        return DDataSink->WriteV(DSegments.data(), DSegments.size());
+    }
+    
+    // Copies the quoted field to Out, doubling each quote, returns the new end
+    static char *FormatQuoted(char *out, std::string_view str){
+        *out++ = '"';
+        const char *Current = str.data();
+        const char *End = Current + str.size();
+        while(const char *Quote = static_cast<const char *>(std::memchr(Current, '"', End - Current))){
+            std::memcpy(out, Current, Quote + 1 - Current);
+            out += Quote + 1 - Current;
+            *out++ = '"'; // Escape quote with another quote
+            Current = Quote + 1;
+        }
+        std::memcpy(out, Current, End - Current);
+        out += End - Current;
+        *out++ = '"';
+        return out;
+    }
+    
+    // Formats the rows into one buffer that goes to the sink in large blocks.
+    // Room for the worst case of a row is made up front so fields are copied
+    // with plain memcpy.
+    bool WriteRows(const std::vector<std::vector<std::string>> &rows){
+        size_t Length = 0;
+        for(auto &Row : rows){
+            size_t WorstCase = Row.size() + 1;
+            for(auto &Field : Row){
+                WorstCase += Field.size() * 2 + 2;
+            }
+            if(DCapacity < Length + WorstCase){
+                Grow(Length, std::max(Length + WorstCase, WriteBlockSize + WorstCase));
+            }
+            char *Out = DBuffer.get() + Length;
+            for(size_t i = 0; i < Row.size(); ++i){
+                if(i > 0){
+                    *Out++ = DDelimiter;
+                }
+                if(NeedsQuoting(Row[i])){
+                    Out = FormatQuoted(Out, Row[i]);
+                }
+                else{
+                    std::memcpy(Out, Row[i].data(), Row[i].size());
+                    Out += Row[i].size();
+                }
+            }
+            *Out++ = '\n';
+            Length = Out - DBuffer.get();
+            if(Length >= WriteBlockSize){
+                if(!DDataSink->Write(DBuffer.get(), Length)){
+                    return false;
+                }
+                Length = 0;
+            }
+        }
+        return !Length || DDataSink->Write(DBuffer.get(), Length);
     }
 };
 
@@ -73,4 +138,8 @@ CDSVWriter::~CDSVWriter(){
 
 bool CDSVWriter::WriteRow(const std::vector<std::string> &row){
     return DImplementation->WriteRow(row);
-} 
\ No newline at end of file
+}
+
+bool CDSVWriter::WriteRows(const std::vector<std::vector<std::string>> &rows){
+    return DImplementation->WriteRows(rows);
+}
@@ -0,0 +1,170 @@
+#include "FileDataSink.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Alignment of the staging buffer, matches the page size of common systems
+static const std::size_t BufferAlignment = 4096;
+
+// Writes all segments, retrying on short writes and interrupts
+static bool WriteAll(int filedescriptor, struct iovec *segments, int count) noexcept{
+    while(count > 0){
+        ssize_t Result = writev(filedescriptor, segments, count);
+        if(Result < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            return false;
+        }
+        std::size_t Written = Result;
+        while(count > 0 && Written >= segments->iov_len){
+            Written -= segments->iov_len;
+            segments++;
+            count--;
+        }
+        if(count > 0){
+            segments->iov_base = static_cast<char *>(segments->iov_base) + Written;
+            segments->iov_len -= Written;
+        }
+    }
+    return true;
+}
+
+CFileDataSink::CFileDataSink(const std::string &filename, bool durable, std::size_t buffersize)
+    : DFileDescriptor(-1), DBuffer(nullptr), DCapacity(0), DLength(0), DDurable(durable){
+    std::size_t Capacity = ((buffersize + BufferAlignment - 1) / BufferAlignment) * BufferAlignment;
+    if(Capacity == 0){
+        Capacity = BufferAlignment;
+    }
+    void *Buffer = nullptr;
+    if(posix_memalign(&Buffer, BufferAlignment, Capacity) != 0){
+        return;
+    }
+    DBuffer = static_cast<char *>(Buffer);
+    DCapacity = Capacity;
+    DFileDescriptor = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+}
+
+CFileDataSink::~CFileDataSink(){
+    Close();
+    free(DBuffer);
+}
+
+bool CFileDataSink::IsOpen() const noexcept{
+    return DFileDescriptor >= 0;
+}
+
+bool CFileDataSink::Flush() noexcept{
+    if(DFileDescriptor < 0){
+        return false;
+    }
+    if(DLength){
+        struct iovec Segment = {DBuffer, DLength};
+        DLength = 0;
+        return WriteAll(DFileDescriptor, &Segment, 1);
+    }
+    return true;
+}
+
+bool CFileDataSink::Close() noexcept{
+    if(DFileDescriptor < 0){
+        return false;
+    }
+    bool Success = Flush();
+    if(DDurable && fsync(DFileDescriptor) != 0){
+        Success = false;
+    }
+    if(close(DFileDescriptor) != 0){
+        Success = false;
+    }
+    DFileDescriptor = -1;
+    return Success;
+}
+
+bool CFileDataSink::Append(const char *data, std::size_t length) noexcept{
+    if(DFileDescriptor < 0){
+        return false;
+    }
+    if(DLength + length <= DCapacity){
+        std::memcpy(DBuffer + DLength, data, length);
+        DLength += length;
+        return true;
+    }
+    if(length < DCapacity){
+        // Top up the buffer so full blocks go out, keep the remainder staged
+        std::size_t Head = DCapacity - DLength;
+        std::memcpy(DBuffer + DLength, data, Head);
+        DLength = DCapacity;
+        if(!Flush()){
+            return false;
+        }
+        std::memcpy(DBuffer, data + Head, length - Head);
+        DLength = length - Head;
+        return true;
+    }
+    // Large writes go out together with the staged bytes in a single writev
+    struct iovec Segments[2] = {{DBuffer, DLength}, {const_cast<char *>(data), length}};
+    DLength = 0;
+    return WriteAll(DFileDescriptor, Segments, 2);
+}
+
+bool CFileDataSink::Put(const char &ch) noexcept{
+    if(DFileDescriptor < 0){
+        return false;
+    }
+    if(DLength == DCapacity && !Flush()){
+        return false;
+    }
+    DBuffer[DLength++] = ch;
+    return true;
+}
+
+bool CFileDataSink::Write(const std::vector<char> &buf) noexcept{
+    return Append(buf.data(), buf.size());
+}
+
+bool CFileDataSink::Write(const char *data, std::size_t length) noexcept{
+    return Append(data, length);
+}
+
+bool CFileDataSink::WriteV(const std::string_view *segments, std::size_t count) noexcept{
+    if(DFileDescriptor < 0){
+        return false;
+    }
+    std::size_t Length = 0;
+    for(std::size_t Index = 0; Index < count; Index++){
+        Length += segments[Index].size();
+    }
+    if(DLength + Length <= DCapacity){
+        for(std::size_t Index = 0; Index < count; Index++){
+            std::memcpy(DBuffer + DLength, segments[Index].data(), segments[Index].size());
+            DLength += segments[Index].size();
+        }
+        return true;
+    }
+    // Staged bytes and segments go out together, IOV_MAX segments at a time
+    struct iovec Segments[IOV_MAX];
+    int SegmentCount = 0;
+    if(DLength){
+        Segments[SegmentCount++] = {DBuffer, DLength};
+        DLength = 0;
+    }
+    for(std::size_t Index = 0; Index < count; Index++){
+        if(segments[Index].empty()){
+            continue;
+        }
+        Segments[SegmentCount++] = {const_cast<char *>(segments[Index].data()), segments[Index].size()};
+        if(SegmentCount == IOV_MAX){
+            if(!WriteAll(DFileDescriptor, Segments, SegmentCount)){
+                return false;
+            }
+            SegmentCount = 0;
+        }
+    }
+    return WriteAll(DFileDescriptor, Segments, SegmentCount);
+}
@@ -0,0 +1,201 @@
+#include "FileDataSource.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Consumed pages of a mapping are returned to the kernel in steps of this size
+// so that resident memory stays bounded on files larger than RAM
+static const std::size_t ReleaseStep = 64 * 1024 * 1024;
+
+CFileDataSource::CFileDataSource(const std::string &filename, std::size_t buffersize)
+    : DFileDescriptor(-1), DMapped(nullptr), DMappedSize(0), DReleased(0), 
+      DData(nullptr), DLength(0), DIndex(0), DEndOfFile(true), DAheadLength(0){
+    DFileDescriptor = open(filename.c_str(), O_RDONLY);
+    if(DFileDescriptor < 0){
+        return;
+    }
+    struct stat Stat;
+    // Files reporting no size, like those under /proc and /sys, may still
+    // have content, so only a nonzero size is trusted
+    if(fstat(DFileDescriptor, &Stat) == 0 && S_ISREG(Stat.st_mode) && Stat.st_size > 0){
+        void *Mapping = mmap(nullptr, Stat.st_size, PROT_READ, MAP_PRIVATE, DFileDescriptor, 0);
+        if(Mapping != MAP_FAILED){
+            DMapped = static_cast<char *>(Mapping);
+            DMappedSize = Stat.st_size;
+            madvise(DMapped, DMappedSize, MADV_SEQUENTIAL);
+            DData = DMapped;
+            DLength = DMappedSize;
+            return;
+        }
+    }
+    // Pipes, character devices, empty and unmappable files are read() into a buffer
+    DBuffer.resize(std::max<std::size_t>(buffersize, 1));
+    DData = DBuffer.data();
+    DEndOfFile = false;
+}
+
+CFileDataSource::~CFileDataSource(){
+    if(DMapped){
+        munmap(DMapped, DMappedSize);
+    }
+    if(DFileDescriptor >= 0){
+        close(DFileDescriptor);
+    }
+}
+
+bool CFileDataSource::IsOpen() const noexcept{
+    return DFileDescriptor >= 0;
+}
+
+bool CFileDataSource::IsMapped() const noexcept{
+    return DMapped != nullptr;
+}
+
+bool CFileDataSource::Fill() const noexcept{
+    if(DIndex < DLength){
+        return true;
+    }
+    if(DAheadLength){
+        DBuffer.swap(DAhead);
+        DData = DBuffer.data();
+        DLength = DAheadLength;
+        DIndex = 0;
+        DAheadLength = 0;
+        return true;
+    }
+    while(!DEndOfFile){
+        ssize_t Result = read(DFileDescriptor, DBuffer.data(), DBuffer.size());
+        if(Result > 0){
+            DIndex = 0;
+            DLength = Result;
+            return true;
+        }
+        if(Result < 0 && errno == EINTR){
+            continue;
+        }
+        DEndOfFile = true;
+    }
+    return false;
+}
+
+void CFileDataSource::ReleaseConsumed() noexcept{
+    if(DMapped && DIndex - DReleased >= ReleaseStep){
+        std::size_t PageSize = sysconf(_SC_PAGESIZE);
+        std::size_t Release = (DIndex / PageSize) * PageSize;
+        // Read-only file pages fault back in unchanged if touched again
+        madvise(DMapped + DReleased, Release - DReleased, MADV_DONTNEED);
+        DReleased = Release;
+    }
+}
+
+// Reads the next block into the spare buffer, leaving the current one as is
+bool CFileDataSource::ReadAhead() const noexcept{
+    try{
+        DAhead.resize(DBuffer.size());
+    }
+    catch(...){
+        // Not known without memory to read into, the next fill finds out
+        return true;
+    }
+    while(!DEndOfFile){
+        ssize_t Result = read(DFileDescriptor, DAhead.data(), DAhead.size());
+        if(Result > 0){
+            DAheadLength = Result;
+            return true;
+        }
+        if(Result < 0 && errno == EINTR){
+            continue;
+        }
+        DEndOfFile = true;
+    }
+    return false;
+}
+
+bool CFileDataSource::End() const noexcept{
+    if(DIndex < DLength || DAheadLength){
+        return false;
+    }
+    return DEndOfFile || !ReadAhead();
+}
+
+bool CFileDataSource::Get(char &ch) noexcept{
+    if(!Fill()){
+        return false;
+    }
+    ch = DData[DIndex++];
+    return true;
+}
+
+bool CFileDataSource::Peek(char &ch) noexcept{
+    if(!Fill()){
+        return false;
+    }
+    ch = DData[DIndex];
+    return true;
+}
+
+bool CFileDataSource::Read(std::vector<char> &buf, std::size_t count) noexcept{
+    buf.clear();
+    try{
+        while(buf.size() < count && Fill()){
+            std::size_t Length = std::min(count - buf.size(), DLength - DIndex);
+            buf.insert(buf.end(), DData + DIndex, DData + DIndex + Length);
+            DIndex += Length;
+        }
+    }
+    catch(...){
+        return false;
+    }
+    return !buf.empty();
+}
+
+bool CFileDataSource::PeekBlock(const char *&data, std::size_t &length) noexcept{
+    ReleaseConsumed();
+    if(!Fill()){
+        length = 0;
+        return false;
+    }
+    data = DData + DIndex;
+    length = DLength - DIndex;
+    return true;
+}
+
+std::size_t CFileDataSource::Consume(std::size_t count) noexcept{
+    std::size_t Consumed = 0;
+    // Refills only happen once the current buffer is used up, so consuming the
+    // bytes of a PeekBlock view never invalidates it
+    while(Consumed < count){
+        if(DIndex >= DLength && (DMapped || !Fill())){
+            break;
+        }
+        std::size_t Length = std::min(count - Consumed, DLength - DIndex);
+        DIndex += Length;
+        Consumed += Length;
+    }
+    return Consumed;
+}
+
+bool CFileDataSource::Seek(std::size_t offset) noexcept{
+    if(DMapped){
+        if(offset > DMappedSize){
+            return false;
+        }
+        DIndex = offset;
+        // Pages before the new position may be released again later
+        std::size_t PageSize = sysconf(_SC_PAGESIZE);
+        DReleased = std::min(DReleased, (offset / PageSize) * PageSize);
+        return true;
+    }
+    if(DFileDescriptor < 0 || lseek(DFileDescriptor, offset, SEEK_SET) < 0){
+        return false;
+    }
+    DIndex = 0;
+    DLength = 0;
+    DAheadLength = 0;
+    DEndOfFile = false;
+    return true;
+}
@@ -0,0 +1,218 @@
+#include "IOUring.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#ifdef HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_IO_URING
+struct CIOUring::SImplementation{
+    int DRingDescriptor;
+    void *DSubmitMap;
+    std::size_t DSubmitMapSize;
+    void *DCompleteMap;
+    std::size_t DCompleteMapSize;
+    struct io_uring_sqe *DEntries;
+    std::size_t DEntriesSize;
+    // Views into the shared rings, the kernel moves the submission head and
+    // the completion tail, this side the other two
+    unsigned *DSubmitHead;
+    unsigned *DSubmitTail;
+    unsigned DSubmitMask;
+    unsigned DSubmitEntries;
+    unsigned *DSubmitArray;
+    unsigned *DCompleteHead;
+    unsigned *DCompleteTail;
+    unsigned DCompleteMask;
+    struct io_uring_cqe *DCompletions;
+    // Requests queued in the ring that the kernel has not taken yet
+    unsigned DUnsubmitted;
+
+    SImplementation(unsigned entries)
+        : DRingDescriptor(-1), DSubmitMap(MAP_FAILED), DSubmitMapSize(0), DCompleteMap(MAP_FAILED), DCompleteMapSize(0),
+          DEntries(static_cast<struct io_uring_sqe *>(MAP_FAILED)), DEntriesSize(0), DUnsubmitted(0){
+        struct io_uring_params Parameters;
+        std::memset(&Parameters, 0, sizeof(Parameters));
+        DRingDescriptor = syscall(__NR_io_uring_setup, entries, &Parameters);
+        if(DRingDescriptor < 0){
+            return;
+        }
+        DSubmitMapSize = Parameters.sq_off.array + Parameters.sq_entries * sizeof(unsigned);
+        DCompleteMapSize = Parameters.cq_off.cqes + Parameters.cq_entries * sizeof(struct io_uring_cqe);
+        bool SingleMap = Parameters.features & IORING_FEAT_SINGLE_MMAP;
+        if(SingleMap){
+            DSubmitMapSize = DCompleteMapSize = std::max(DSubmitMapSize, DCompleteMapSize);
+        }
+        DSubmitMap = mmap(nullptr, DSubmitMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, DRingDescriptor, IORING_OFF_SQ_RING);
+        DCompleteMap = SingleMap ? DSubmitMap : mmap(nullptr, DCompleteMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, DRingDescriptor, IORING_OFF_CQ_RING);
+        DEntriesSize = Parameters.sq_entries * sizeof(struct io_uring_sqe);
+        DEntries = static_cast<struct io_uring_sqe *>(mmap(nullptr, DEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, DRingDescriptor, IORING_OFF_SQES));
+        if(DSubmitMap == MAP_FAILED || DCompleteMap == MAP_FAILED || DEntries == MAP_FAILED){
+            Close();
+            return;
+        }
+        char *Submit = static_cast<char *>(DSubmitMap);
+        DSubmitHead = reinterpret_cast<unsigned *>(Submit + Parameters.sq_off.head);
+        DSubmitTail = reinterpret_cast<unsigned *>(Submit + Parameters.sq_off.tail);
+        DSubmitMask = *reinterpret_cast<unsigned *>(Submit + Parameters.sq_off.ring_mask);
+        DSubmitEntries = *reinterpret_cast<unsigned *>(Submit + Parameters.sq_off.ring_entries);
+        DSubmitArray = reinterpret_cast<unsigned *>(Submit + Parameters.sq_off.array);
+        char *Complete = static_cast<char *>(DCompleteMap);
+        DCompleteHead = reinterpret_cast<unsigned *>(Complete + Parameters.cq_off.head);
+        DCompleteTail = reinterpret_cast<unsigned *>(Complete + Parameters.cq_off.tail);
+        DCompleteMask = *reinterpret_cast<unsigned *>(Complete + Parameters.cq_off.ring_mask);
+        DCompletions = reinterpret_cast<struct io_uring_cqe *>(Complete + Parameters.cq_off.cqes);
+    }
+
+    ~SImplementation(){
+        Close();
+    }
+
+    void Close(){
+        if(DEntries != MAP_FAILED){
+            munmap(DEntries, DEntriesSize);
+        }
+        if(DCompleteMap != MAP_FAILED && DCompleteMap != DSubmitMap){
+            munmap(DCompleteMap, DCompleteMapSize);
+        }
+        if(DSubmitMap != MAP_FAILED){
+            munmap(DSubmitMap, DSubmitMapSize);
+        }
+        DEntries = static_cast<struct io_uring_sqe *>(MAP_FAILED);
+        DSubmitMap = DCompleteMap = MAP_FAILED;
+        if(DRingDescriptor >= 0){
+            close(DRingDescriptor);
+        }
+        DRingDescriptor = -1;
+    }
+
+    bool Prepare(uint8_t opcode, int fd, const char *buffer, std::size_t length, off_t offset, int bufferindex, uint64_t data){
+        unsigned Tail = *DSubmitTail;
+        if(Tail - __atomic_load_n(DSubmitHead, __ATOMIC_ACQUIRE) >= DSubmitEntries){
+            return false;
+        }
+        unsigned Index = Tail & DSubmitMask;
+        struct io_uring_sqe &Entry = DEntries[Index];
+        std::memset(&Entry, 0, sizeof(Entry));
+        Entry.opcode = opcode;
+        Entry.fd = fd;
+        Entry.addr = reinterpret_cast<uint64_t>(buffer);
+        Entry.len = length;
+        Entry.off = offset;
+        Entry.user_data = data;
+        if(bufferindex >= 0){
+            Entry.buf_index = bufferindex;
+        }
+        DSubmitArray[Index] = Index;
+        // The entry must be visible before the kernel sees the new tail
+        __atomic_store_n(DSubmitTail, Tail + 1, __ATOMIC_RELEASE);
+        DUnsubmitted++;
+        return true;
+    }
+
+    // Submits the queued requests and optionally waits for one completion
+    bool Enter(bool wait){
+        while(DUnsubmitted || wait){
+            int Result = syscall(__NR_io_uring_enter, DRingDescriptor, DUnsubmitted, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            if(Result < 0){
+                if(errno == EINTR){
+                    continue;
+                }
+                return false;
+            }
+            DUnsubmitted -= std::min<unsigned>(Result, DUnsubmitted);
+            if(wait){
+                break;
+            }
+        }
+        return true;
+    }
+
+    bool WaitCompletion(uint64_t &data, int &result){
+        while(true){
+            unsigned Head = *DCompleteHead;
+            if(Head != __atomic_load_n(DCompleteTail, __ATOMIC_ACQUIRE)){
+                struct io_uring_cqe &Completion = DCompletions[Head & DCompleteMask];
+                data = Completion.user_data;
+                result = Completion.res;
+                // The entry is read before the kernel may reuse it
+                __atomic_store_n(DCompleteHead, Head + 1, __ATOMIC_RELEASE);
+                return true;
+            }
+            if(!Enter(true)){
+                return false;
+            }
+        }
+    }
+};
+
+CIOUring::CIOUring(unsigned entries){
+    DImplementation = std::make_unique<SImplementation>(entries);
+}
+
+CIOUring::~CIOUring(){
+}
+
+bool CIOUring::IsOpen() const noexcept{
+    return DImplementation->DRingDescriptor >= 0;
+}
+
+bool CIOUring::RegisterBuffers(const struct iovec *vectors, unsigned count) noexcept{
+    return IsOpen() && syscall(__NR_io_uring_register, DImplementation->DRingDescriptor, IORING_REGISTER_BUFFERS, vectors, count) == 0;
+}
+
+bool CIOUring::PrepareRead(int fd, char *buffer, std::size_t length, off_t offset, int bufferindex, uint64_t data) noexcept{
+    return IsOpen() && DImplementation->Prepare(bufferindex >= 0 ? IORING_OP_READ_FIXED : IORING_OP_READ, fd, buffer, length, offset, bufferindex, data);
+}
+
+bool CIOUring::PrepareWrite(int fd, const char *buffer, std::size_t length, off_t offset, int bufferindex, uint64_t data) noexcept{
+    return IsOpen() && DImplementation->Prepare(bufferindex >= 0 ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE, fd, buffer, length, offset, bufferindex, data);
+}
+
+bool CIOUring::Submit() noexcept{
+    return IsOpen() && DImplementation->Enter(false);
+}
+
+bool CIOUring::WaitCompletion(uint64_t &data, int &result) noexcept{
+    return IsOpen() && DImplementation->WaitCompletion(data, result);
+}
+
+#else
+struct CIOUring::SImplementation{
+};
+
+CIOUring::CIOUring(unsigned entries){
+    (void)entries;
+}
+
+CIOUring::~CIOUring(){
+}
+
+bool CIOUring::IsOpen() const noexcept{
+    return false;
+}
+
+bool CIOUring::RegisterBuffers(const struct iovec *vectors, unsigned count) noexcept{
+    return false;
+}
+
+bool CIOUring::PrepareRead(int fd, char *buffer, std::size_t length, off_t offset, int bufferindex, uint64_t data) noexcept{
+    return false;
+}
+
+bool CIOUring::PrepareWrite(int fd, const char *buffer, std::size_t length, off_t offset, int bufferindex, uint64_t data) noexcept{
+    return false;
+}
+
+bool CIOUring::Submit() noexcept{
+    return false;
+}
+
+bool CIOUring::WaitCompletion(uint64_t &data, int &result) noexcept{
+    return false;
+}
+#endif
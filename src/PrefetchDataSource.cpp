@@ -0,0 +1,155 @@
+#include "PrefetchDataSource.h"
+#include <algorithm>
+#include <cstring>
+
+CPrefetchDataSource::CPrefetchDataSource(std::shared_ptr< CDataSource > src, std::size_t blocksize, std::size_t blockcount)
+    : DSource(src), DHead(0), DTail(0), DIndex(0), DFilled(0), DHolding(false), DSourceDone(false), DStop(false){
+    DBuffers.resize(std::max<std::size_t>(blockcount, 2));
+    for(auto &Buffer : DBuffers){
+        Buffer.resize(std::max<std::size_t>(blocksize, 1));
+    }
+    DLengths.resize(DBuffers.size(), 0);
+    DThread = std::thread(&CPrefetchDataSource::Prefetch, this);
+}
+
+CPrefetchDataSource::~CPrefetchDataSource(){
+    {
+        std::lock_guard<std::mutex> Lock(DMutex);
+        DStop = true;
+    }
+    DFreeCondition.notify_all();
+    DThread.join();
+}
+
+void CPrefetchDataSource::Prefetch() noexcept{
+    while(true){
+        std::size_t Slot;
+        {
+            std::unique_lock<std::mutex> Lock(DMutex);
+            DFreeCondition.wait(Lock, [this]{ return DStop || DFilled < DBuffers.size(); });
+            if(DStop){
+                return;
+            }
+            Slot = DTail;
+        }
+        // The slot is not visible to the reader until it is published below
+        std::vector<char> &Buffer = DBuffers[Slot];
+        std::size_t Length = 0;
+        const char *Block;
+        std::size_t BlockLength;
+        while(Length < Buffer.size() && DSource->PeekBlock(Block, BlockLength)){
+            BlockLength = std::min(BlockLength, Buffer.size() - Length);
+            std::memcpy(Buffer.data() + Length, Block, BlockLength);
+            DSource->Consume(BlockLength);
+            Length += BlockLength;
+        }
+        bool Done = DSource->End();
+        {
+            std::lock_guard<std::mutex> Lock(DMutex);
+            if(Length){
+                DLengths[Slot] = Length;
+                DTail = (DTail + 1) % DBuffers.size();
+                DFilled++;
+            }
+            DSourceDone = Done || !Length;
+        }
+        DFilledCondition.notify_one();
+        if(Done || !Length){
+            return;
+        }
+    }
+}
+
+// Waits until the head block has unread bytes, returns false at end of data
+bool CPrefetchDataSource::Fill() const noexcept{
+    if(DHolding && DIndex < DLengths[DHead]){
+        return true;
+    }
+    if(DHolding){
+        Release();
+    }
+    std::unique_lock<std::mutex> Lock(DMutex);
+    DFilledCondition.wait(Lock, [this]{ return DFilled > 0 || DSourceDone; });
+    DHolding = DFilled > 0;
+    return DHolding;
+}
+
+// Hands the exhausted head block back to the background thread
+void CPrefetchDataSource::Release() const noexcept{
+    {
+        std::lock_guard<std::mutex> Lock(DMutex);
+        DHead = (DHead + 1) % DBuffers.size();
+        DIndex = 0;
+        DFilled--;
+        DHolding = false;
+    }
+    DFreeCondition.notify_one();
+}
+
+// Looks for unread bytes without releasing the head block, which views from
+// PeekBlock may still point into
+bool CPrefetchDataSource::End() const noexcept{
+    if(DHolding && DIndex < DLengths[DHead]){
+        return false;
+    }
+    std::unique_lock<std::mutex> Lock(DMutex);
+    std::size_t Held = DHolding ? 1 : 0;
+    DFilledCondition.wait(Lock, [this, Held]{ return DFilled > Held || DSourceDone; });
+    return DFilled == Held;
+}
+
+bool CPrefetchDataSource::Get(char &ch) noexcept{
+    if(!Fill()){
+        return false;
+    }
+    ch = DBuffers[DHead][DIndex++];
+    return true;
+}
+
+bool CPrefetchDataSource::Peek(char &ch) noexcept{
+    if(!Fill()){
+        return false;
+    }
+    ch = DBuffers[DHead][DIndex];
+    return true;
+}
+
+bool CPrefetchDataSource::Read(std::vector<char> &buf, std::size_t count) noexcept{
+    buf.clear();
+    try{
+        while(buf.size() < count && Fill()){
+            std::size_t Length = std::min(count - buf.size(), DLengths[DHead] - DIndex);
+            const char *Data = DBuffers[DHead].data() + DIndex;
+            buf.insert(buf.end(), Data, Data + Length);
+            DIndex += Length;
+        }
+    }
+    catch(...){
+        return false;
+    }
+    return !buf.empty();
+}
+
+bool CPrefetchDataSource::PeekBlock(const char *&data, std::size_t &length) noexcept{
+    if(!Fill()){
+        length = 0;
+        return false;
+    }
+    data = DBuffers[DHead].data() + DIndex;
+    length = DLengths[DHead] - DIndex;
+    return true;
+}
+
+std::size_t CPrefetchDataSource::Consume(std::size_t count) noexcept{
+    std::size_t Consumed = 0;
+    // The head block is only released by the next fill, keeping views valid
+    while(Consumed < count){
+        if(!(DHolding && DIndex < DLengths[DHead]) && !Fill()){
+            break;
+        }
+        std::size_t Length = std::min(count - Consumed, DLengths[DHead] - DIndex);
+        DIndex += Length;
+        Consumed += Length;
+    }
+    return Consumed;
+}
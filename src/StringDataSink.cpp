@@ -1,4 +1,5 @@
 #include "StringDataSink.h"
+#include <algorithm>
 
 CStringDataSink::CStringDataSink() noexcept : DString(){
     
@@ -27,3 +28,32 @@ bool CStringDataSink::Write(const std::vector<char> &buf) noexcept{
         return false;
     }
 }
+
+bool CStringDataSink::Write(const char *data, std::size_t length) noexcept{
+    try {
+        DString.append(data, length);
+        return true;
+    }
+    catch(...) {
+        return false;
+    }
+}
+
+bool CStringDataSink::WriteV(const std::string_view *segments, std::size_t count) noexcept{
+    try {
+        std::size_t Length = DString.length();
+        for(std::size_t Index = 0; Index < count; Index++){
+            Length += segments[Index].size();
+        }
+        if(Length > DString.capacity()){
+            DString.reserve(std::max(Length, DString.capacity() * 2));
+        }
+        for(std::size_t Index = 0; Index < count; Index++){
+            DString.append(segments[Index].data(), segments[Index].size());
+        }
+        return true;
+    }
+    catch(...) {
+        return false;
+    }
+}
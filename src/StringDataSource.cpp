@@ -1,16 +1,28 @@
 #include "StringDataSource.h"
 
-CStringDataSource::CStringDataSource(const std::string &str) : DString(str), DIndex(0){
+CStringDataSource::CStringDataSource(const std::string &str) : DString(str), DView(DString), DIndex(0){
+
+}
+
+CStringDataSource::CStringDataSource(const char *str) : DString(str), DView(DString), DIndex(0){
+
+}
+
+CStringDataSource::CStringDataSource(std::string &&str) noexcept : DString(std::move(str)), DView(DString), DIndex(0){
+
+}
+
+CStringDataSource::CStringDataSource(std::string_view view) noexcept : DView(view), DIndex(0){
 
 }
 
 bool CStringDataSource::End() const noexcept{
-    return DIndex >= DString.length();
+    return DIndex >= DView.length();
 }
 
 bool CStringDataSource::Get(char &ch) noexcept{
-    if(DIndex < DString.length()){
-        ch = DString[DIndex];
+    if(DIndex < DView.length()){
+        ch = DView[DIndex];
         DIndex++;
         return true;
     }
@@ -18,8 +30,8 @@ bool CStringDataSource::Get(char &ch) noexcept{
 }
 
 bool CStringDataSource::Peek(char &ch) noexcept{
-    if(DIndex < DString.length()){
-        ch = DString[DIndex];
+    if(DIndex < DView.length()){
+        ch = DView[DIndex];
         return true;
     }
     return false;
@@ -27,14 +39,39 @@ bool CStringDataSource::Peek(char &ch) noexcept{
 
 bool CStringDataSource::Read(std::vector<char> &buf, std::size_t count) noexcept{
     buf.clear();
-    while(buf.size() < count){
-        char TempChar;
-        if(Get(TempChar)){
-            buf.push_back(TempChar);
-        }
-        else{
-            break;
-        }
+    std::size_t Remaining = DIndex < DView.length() ? DView.length() - DIndex : 0;
+    std::size_t Length = count < Remaining ? count : Remaining;
+    try{
+        buf.assign(DView.data() + DIndex, DView.data() + DIndex + Length);
+    }
+    catch(...){
+        return false;
     }
+    DIndex += Length;
     return !buf.empty();
 }
+
+bool CStringDataSource::PeekBlock(const char *&data, std::size_t &length) noexcept{
+    if(DIndex < DView.length()){
+        data = DView.data() + DIndex;
+        length = DView.length() - DIndex;
+        return true;
+    }
+    length = 0;
+    return false;
+}
+
+std::size_t CStringDataSource::Consume(std::size_t count) noexcept{
+    std::size_t Remaining = DIndex < DView.length() ? DView.length() - DIndex : 0;
+    std::size_t Consumed = count < Remaining ? count : Remaining;
+    DIndex += Consumed;
+    return Consumed;
+}
+
+bool CStringDataSource::Seek(std::size_t offset) noexcept{
+    if(offset > DView.length()){
+        return false;
+    }
+    DIndex = offset;
+    return true;
+}
@@ -2,6 +2,8 @@
 #include <expat.h>
 #include <queue>
 #include <algorithm>
+#include <cstring>
+#include <cstdint>
 
 struct CXMLReader::SImplementation {
     std::shared_ptr<CDataSource> DDataSource;
@@ -9,51 +11,203 @@ struct CXMLReader::SImplementation {
     std::queue<SXMLEntity> DEntityQueue;
     bool DError;
     std::string DCurrentCharData;
+    size_t DChunkSize;
+    // Set while Parse runs, entities then go to the visitor instead of the queue
+    CXMLVisitor *DVisitor;
+    std::vector<CXMLVisitor::TAttribute> DVisitorAttributes;
+    CXMLNameTable DNames;
+    // Names are only interned after InternNames, and no more than this many
+    size_t DMaxNames;
+    // The storage of the entity last replaced by ReadEntity, new entities
+    // are built in it so their strings and vectors are reused
+    SXMLEntity DSpare;
+    // Limits from SetLimits, DFed counts the bytes handed to Expat and
+    // DEventEnd the input offset just past the last event it reported
+    size_t DMaxCharData;
+    size_t DMaxMarkup;
+    // Set once the current run of text has handed on more than whitespace
+    bool DCharDataStarted;
+    uint64_t DFed;
+    uint64_t DEventEnd;
+    
+    bool Suspended() {
+        XML_ParsingStatus Status;
+        XML_GetParsingStatus(DParser, &Status);
+        return Status.parsing == XML_SUSPENDED;
+    }
+    
+    // Queues an entity for ReadEntity and suspends Expat, so the rest of the
+    // buffer is only parsed once the queue has been read
+    void Push(SXMLEntity &entity) {
+        DEntityQueue.push(std::move(entity));
+        XML_ParsingStatus Status;
+        XML_GetParsingStatus(DParser, &Status);
+        if(Status.parsing == XML_PARSING){
+            XML_StopParser(DParser, XML_TRUE);
+        }
+    }
+    
+    SXMLEntity NewEntity(SXMLEntity::EType type, const char *name) {
+        SXMLEntity Entity = std::move(DSpare);
+        DSpare = SXMLEntity();
+        Entity.DType = type;
+        Entity.DNameData.assign(name);
+        Entity.DNameID = 0;
+        Entity.DAttributeIDs.clear();
+        Entity.DAttributeOrder.clear();
+        return Entity;
+    }
+    
+    // The ID of a name, new names are added while the table has room
+    CXMLNameTable::TNameID NameID(const char *name) {
+        return DNames.Size() < DMaxNames ? DNames.Intern(name) : DNames.Find(name);
+    }
+    
+    void Fail() {
+        DError = true;
+        XML_StopParser(DParser, XML_FALSE);
+    }
+    
+    // Records where the event being reported ends in the input, and returns
+    // its size there
+    size_t MarkEvent() {
+        XML_Index Index = XML_GetCurrentByteIndex(DParser);
+        size_t Count = XML_GetCurrentByteCount(DParser);
+        if(Index >= 0){
+            DEventEnd = std::max<uint64_t>(DEventEnd, Index + Count);
+        }
+        return Count;
+    }
+    
+    void EmitCharData() {
+        if(DVisitor){
+            DVisitor->CharData(DCurrentCharData);
+        }
+        else{
+            SXMLEntity Entity = NewEntity(SXMLEntity::EType::CharData, "");
+            Entity.DNameData = DCurrentCharData;
+            Entity.DAttributes.clear();
+            Push(Entity);
+        }
+        DCurrentCharData.clear();
+    }
+    
+    // Hands on the character data gathered since the last tag, text that is
+    // only whitespace is kept and joins the next run unless it ends a run
+    // already handed on in pieces
+    void FlushCharData() {
+        if(!DCurrentCharData.empty() && (DCharDataStarted || !WhitespaceOnly())) {
+            EmitCharData();
+        }
+        DCharDataStarted = false;
+    }
+    
+    bool WhitespaceOnly() const {
+        return std::all_of(DCurrentCharData.begin(), DCurrentCharData.end(), ::isspace);
+    }
     
     static void StartElementHandler(void *userData, const XML_Char *name, const XML_Char **attrs) {
         auto Implementation = static_cast<SImplementation*>(userData);
-        if(!Implementation->DCurrentCharData.empty() && 
-           !std::all_of(Implementation->DCurrentCharData.begin(), Implementation->DCurrentCharData.end(), ::isspace)) {
-            SXMLEntity Entity;
-            Entity.DType = SXMLEntity::EType::CharData;
-            Entity.DNameData = Implementation->DCurrentCharData;
-            Implementation->DEntityQueue.push(Entity);
-            Implementation->DCurrentCharData.clear();
-        }
+        size_t Size = Implementation->MarkEvent();
+        Implementation->FlushCharData();
         
-        SXMLEntity Entity;
-        Entity.DType = SXMLEntity::EType::StartElement;
-        Entity.DNameData = name;
-        for(size_t Index = 0; attrs[Index]; Index += 2){
-            Entity.DAttributes.push_back(std::make_pair(attrs[Index], attrs[Index + 1]));
+        // Both the tag as written and its name and attributes once entity
+        // references are expanded must fit the markup limit
+        if(Implementation->DMaxMarkup != SIZE_MAX){
+            size_t Expanded = std::strlen(name);
+            for(size_t Index = 0; attrs[Index]; Index++){
+                Expanded += std::strlen(attrs[Index]);
+            }
+            if(std::max(Size, Expanded) > Implementation->DMaxMarkup){
+                Implementation->Fail();
+                return;
+            }
+        }
+        if(Implementation->DVisitor){
+            Implementation->DVisitorAttributes.clear();
+            for(size_t Index = 0; attrs[Index]; Index += 2){
+                Implementation->DVisitorAttributes.emplace_back(attrs[Index], attrs[Index + 1]);
+            }
+            Implementation->DVisitor->StartElement(name, Implementation->DVisitorAttributes);
+            return;
+        }
+        SXMLEntity Entity = Implementation->NewEntity(SXMLEntity::EType::StartElement, name);
+        bool Interning = Implementation->DMaxNames;
+        if(Interning){
+            Entity.DNameID = Implementation->NameID(name);
         }
-        Implementation->DEntityQueue.push(Entity);
+        size_t Count = 0;
+        for(size_t Index = 0; attrs[Index]; Index += 2, Count++){
+            if(Count < Entity.DAttributes.size()){
+                Entity.DAttributes[Count].first.assign(attrs[Index]);
+                Entity.DAttributes[Count].second.assign(attrs[Index + 1]);
+            }
+            else{
+                Entity.DAttributes.emplace_back(attrs[Index], attrs[Index + 1]);
+            }
+            if(Interning){
+                Entity.DAttributeIDs.push_back(Implementation->NameID(attrs[Index]));
+            }
+        }
+        Entity.DAttributes.resize(Count);
+        Entity.IndexAttributes();
+        Implementation->Push(Entity);
     }
     
     static void EndElementHandler(void *userData, const XML_Char *name) {
         auto Implementation = static_cast<SImplementation*>(userData);
-        if(!Implementation->DCurrentCharData.empty() && 
-           !std::all_of(Implementation->DCurrentCharData.begin(), Implementation->DCurrentCharData.end(), ::isspace)) {
-            SXMLEntity Entity;
-            Entity.DType = SXMLEntity::EType::CharData;
-            Entity.DNameData = Implementation->DCurrentCharData;
-            Implementation->DEntityQueue.push(Entity);
-            Implementation->DCurrentCharData.clear();
-        }
+        Implementation->MarkEvent();
+        Implementation->FlushCharData();
         
-        SXMLEntity Entity;
-        Entity.DType = SXMLEntity::EType::EndElement;
-        Entity.DNameData = name;
-        Implementation->DEntityQueue.push(Entity);
+        if(Implementation->DVisitor){
+            Implementation->DVisitor->EndElement(name);
+            return;
+        }
+        SXMLEntity Entity = Implementation->NewEntity(SXMLEntity::EType::EndElement, name);
+        if(Implementation->DMaxNames){
+            Entity.DNameID = Implementation->NameID(name);
+        }
+        Entity.DAttributes.clear();
+        Implementation->Push(Entity);
     }
     
+    // Text longer than DMaxCharData is handed on in pieces of that size. A
+    // full piece of only whitespace at the start of a run cannot be held back
+    // within the limit, so it is dropped, like whitespace-only text is never
+    // handed on without limits. Once a run has started, pieces go verbatim.
     static void CharDataHandler(void *userData, const XML_Char *s, int len) {
         auto Implementation = static_cast<SImplementation*>(userData);
-        Implementation->DCurrentCharData.append(s, len);
+        Implementation->MarkEvent();
+        size_t Length = len;
+        while(Length){
+            size_t Count = std::min(Length, Implementation->DMaxCharData - Implementation->DCurrentCharData.size());
+            Implementation->DCurrentCharData.append(s, Count);
+            s += Count;
+            Length -= Count;
+            if(Implementation->DCurrentCharData.size() >= Implementation->DMaxCharData){
+                if(!Implementation->DCharDataStarted && Implementation->WhitespaceOnly()){
+                    Implementation->DCurrentCharData.clear();
+                }
+                else{
+                    Implementation->DCharDataStarted = true;
+                    Implementation->EmitCharData();
+                }
+            }
+        }
     }
     
-    SImplementation(std::shared_ptr<CDataSource> src) 
-        : DDataSource(src), DError(false) {
+    // Only set with a markup limit, so comments, processing instructions and
+    // declarations also count as events
+    static void DefaultHandler(void *userData, const XML_Char *s, int len) {
+        auto Implementation = static_cast<SImplementation*>(userData);
+        if(Implementation->MarkEvent() > Implementation->DMaxMarkup){
+            Implementation->Fail();
+        }
+    }
+    
+    SImplementation(std::shared_ptr<CDataSource> src, size_t chunksize)
+        : DDataSource(src), DError(false), DChunkSize(std::min<size_t>(std::max<size_t>(chunksize, 1), 1 << 30)), DVisitor(nullptr),
+          DMaxNames(0), DMaxCharData(SIZE_MAX), DMaxMarkup(SIZE_MAX), DCharDataStarted(false), DFed(0), DEventEnd(0) {
         DParser = XML_ParserCreate(NULL);
         XML_SetUserData(DParser, this);
         XML_SetElementHandler(DParser, StartElementHandler, EndElementHandler);
@@ -64,68 +218,151 @@ struct CXMLReader::SImplementation {
         XML_ParserFree(DParser);
     }
     
-    bool End() const {
-        return DEntityQueue.empty() && DDataSource->End();
+    void SetLimits(size_t maxchardata, size_t maxmarkup) {
+        DMaxCharData = maxchardata ? maxchardata : SIZE_MAX;
+        DMaxMarkup = maxmarkup ? maxmarkup : SIZE_MAX;
+        XML_SetDefaultHandlerExpand(DParser, maxmarkup ? DefaultHandler : nullptr);
     }
     
-    bool ReadEntity(SXMLEntity &entity, bool skipcdata = false) {
-        if(DError){
-            return false;
+    // A suspended parser may still hold entities, so it is resumed until one
+    // arrives or its buffer is done
+    bool End() {
+        while(DEntityQueue.empty() && !DError && Suspended()){
+            ParseChunk();
         }
-        
-        while(DEntityQueue.empty() && !DDataSource->End()){
-            std::vector<char> Buffer;
-            Buffer.resize(1024);
-            size_t BytesRead = 0;
-            
-            // Read data into buffer
-            while(BytesRead < Buffer.size() && !DDataSource->End()){
-                char Ch;
-                if(DDataSource->Get(Ch)){
-                    Buffer[BytesRead] = Ch;
-                    BytesRead++;
-                }
+        return DEntityQueue.empty() && !Suspended() && DDataSource->End();
+    }
+    
+    // Feeds the next chunk of the source to Expat, false at the end of the
+    // source or on a parse error. Source blocks are copied straight into
+    // Expat's own buffer, which XML_Parse would otherwise copy them into.
+    // A parser suspended by Push is resumed on the chunk it already holds.
+    bool ParseChunk() {
+        XML_Status Result;
+        if(Suspended()){
+            Result = XML_ResumeParser(DParser);
+        }
+        else{
+            const char *Block;
+            size_t Length;
+            if(DDataSource->End() || !DDataSource->PeekBlock(Block, Length)){
+                return false;
             }
             
-            // Parse the data
-            if(BytesRead > 0){
-                if(XML_Parse(DParser, Buffer.data(), BytesRead, DDataSource->End()) == XML_STATUS_ERROR){
-                    DError = true;
-                    return false;
-                }
+            char *Buffer = static_cast<char *>(XML_GetBuffer(DParser, DChunkSize));
+            if(!Buffer){
+                DError = true;
+                return false;
+            }
+            size_t Filled = 0;
+            while(Filled < DChunkSize && DDataSource->PeekBlock(Block, Length)){
+                Length = std::min(Length, DChunkSize - Filled);
+                std::memcpy(Buffer + Filled, Block, Length);
+                DDataSource->Consume(Length);
+                Filled += Length;
             }
+            DFed += Filled;
+            
+            // The bytes are already in Expat's buffer, so asking End after
+            // Consume cannot change what is parsed
+            Result = XML_ParseBuffer(DParser, Filled, DDataSource->End());
         }
-        
-        if(DEntityQueue.empty()){
+        if(DError || Result == XML_STATUS_ERROR){
+            DError = true;
+            return false;
+        }
+        // Bytes fed since the last event are one unfinished token that Expat
+        // keeps buffered, such as a long tag
+        if(Result == XML_STATUS_OK && DFed - DEventEnd > DMaxMarkup){
+            DError = true;
+            return false;
+        }
+        return true;
+    }
+    
+    bool ReadEntity(SXMLEntity &entity, bool skipcdata = false) {
+        if(DError){
             return false;
         }
         
-        if(skipcdata){
-            while(!DEntityQueue.empty() && DEntityQueue.front().DType == SXMLEntity::EType::CharData){
-                DEntityQueue.pop();
+        // Character data may be queued on its own, so skipping it can empty
+        // the queue while the parser still has input
+        while(true){
+            while(DEntityQueue.empty() && ParseChunk()){
             }
-            if(DEntityQueue.empty()){
+            if(DError || DEntityQueue.empty()){
                 return false;
             }
+            if(!skipcdata || DEntityQueue.front().DType != SXMLEntity::EType::CharData){
+                break;
+            }
+            DEntityQueue.pop();
         }
         
-        entity = DEntityQueue.front();
+        std::swap(entity, DEntityQueue.front());
+        DSpare = std::move(DEntityQueue.front());
         DEntityQueue.pop();
         return true;
     }
+    
+    bool Parse(CXMLVisitor &visitor) {
+        if(DError){
+            return false;
+        }
+        // Entities already parsed for ReadEntity are delivered first
+        while(!DEntityQueue.empty()){
+            SXMLEntity &Entity = DEntityQueue.front();
+            if(Entity.DType == SXMLEntity::EType::StartElement){
+                DVisitorAttributes.clear();
+                for(auto &Attribute : Entity.DAttributes){
+                    DVisitorAttributes.emplace_back(Attribute.first, Attribute.second);
+                }
+                visitor.StartElement(Entity.DNameData, DVisitorAttributes);
+            }
+            else if(Entity.DType == SXMLEntity::EType::EndElement){
+                visitor.EndElement(Entity.DNameData);
+            }
+            else{
+                visitor.CharData(Entity.DNameData);
+            }
+            DEntityQueue.pop();
+        }
+        
+        DVisitor = &visitor;
+        while(ParseChunk()){
+        }
+        DVisitor = nullptr;
+        return !DError;
+    }
 };
 
-CXMLReader::CXMLReader(std::shared_ptr<CDataSource> src) {
-    DImplementation = std::make_unique<SImplementation>(src);
+CXMLReader::CXMLReader(std::shared_ptr<CDataSource> src, std::size_t chunksize) {
+    DImplementation = std::make_unique<SImplementation>(src, chunksize);
 }
 
 CXMLReader::~CXMLReader() {
 }
 
+void CXMLReader::InternNames(std::size_t maxnames) {
+    DImplementation->DMaxNames = maxnames;
+}
+
+CXMLNameTable &CXMLReader::Names() {
+    return DImplementation->DNames;
+}
+
 bool CXMLReader::End() const {
     return DImplementation->End();
 }
 
+void CXMLReader::SetLimits(std::size_t maxchardata, std::size_t maxmarkup) {
+    DImplementation->SetLimits(maxchardata, maxmarkup);
+}
+
 bool CXMLReader::ReadEntity(SXMLEntity &entity, bool skipcdata) {
     return DImplementation->ReadEntity(entity, skipcdata);
-} 
\ No newline at end of file
+}
+
+bool CXMLReader::Parse(CXMLVisitor &visitor) {
+    return DImplementation->Parse(visitor);
+}
@@ -1,123 +1,89 @@
 #include "XMLWriter.h"
 #include <stack>
 #include <algorithm>
+#include <string_view>
 
 struct CXMLWriter::SImplementation {
     std::shared_ptr<CDataSink> DDataSink;
     std::stack<std::string> DElementStack;
     bool DIndent;
+    std::vector<std::string_view> DSegments;
     
     SImplementation(std::shared_ptr<CDataSink> sink) 
         : DDataSink(sink), DIndent(true) {
     }
     
-    bool WriteString(const std::string &str) {
-        for(char ch : str) {
-            if(!DDataSink->Put(ch)) {
-                return false;
-            }
-        }
-        return true;
-    }
-    
     bool WriteIndent() {
         return true;
     }
     
-    bool WriteEscaped(const std::string &str) {
-        for(char ch : str) {
-            switch(ch) {
-                case '<': if(!WriteString("&lt;")) return false; break;
-                case '>': if(!WriteString("&gt;")) return false; break;
-                case '&': if(!WriteString("&amp;")) return false; break;
-                case '\'': if(!WriteString("&apos;")) return false; break;
-                case '"': if(!WriteString("&quot;")) return false; break;
-                default: if(!DDataSink->Put(ch)) return false;
+    // Adds the string as segments, runs without special characters are kept
+    // whole and special characters are replaced by their entities
+    void AppendEscaped(std::string_view str) {
+        size_t Start = 0;
+        for(size_t Index = 0; Index < str.size(); Index++) {
+            std::string_view Entity;
+            switch(str[Index]) {
+                case '<': Entity = "&lt;"; break;
+                case '>': Entity = "&gt;"; break;
+                case '&': Entity = "&amp;"; break;
+                case '\'': Entity = "&apos;"; break;
+                case '"': Entity = "&quot;"; break;
+                default: continue;
             }
+            if(Index > Start) {
+                DSegments.push_back(str.substr(Start, Index - Start));
+            }
+            DSegments.push_back(Entity);
+            Start = Index + 1;
         }
-        return true;
+        if(Start < str.size()) {
+            DSegments.push_back(str.substr(Start));
+        }
+    }
+    
+    void AppendTag(const SXMLEntity &entity, std::string_view close) {
+        DSegments.push_back("<");
+        DSegments.push_back(entity.DNameData);
+        for(const auto &attr : entity.DAttributes) {
+            DSegments.push_back(" ");
+            DSegments.push_back(attr.first);
+            DSegments.push_back("=\"");
+            AppendEscaped(attr.second);
+            DSegments.push_back("\"");
+        }
+        DSegments.push_back(close);
     }
     
+    // Each entity is handed to the sink in a single gathered write
     bool WriteEntity(const SXMLEntity &entity) {
+        DSegments.clear();
         switch(entity.DType) {
             case SXMLEntity::EType::StartElement:
-                if(!WriteString("<")) {
-                    return false;
-                }
-                if(!WriteString(entity.DNameData)) {
-                    return false;
-                }
-                for(const auto &attr : entity.DAttributes) {
-                    if(!WriteString(" ")) {
-                        return false;
-                    }
-                    if(!WriteString(attr.first)) {
-                        return false;
-                    }
-                    if(!WriteString("=\"")) {
-                        return false;
-                    }
-                    if(!WriteEscaped(attr.second)) {
-                        return false;
-                    }
-                    if(!WriteString("\"")) {
-                        return false;
-                    }
-                }
-                if(!WriteString(">")) {
-                    return false;
-                }
-                DElementStack.push(entity.DNameData);
+                AppendTag(entity, ">");
                 break;
                 
             case SXMLEntity::EType::EndElement:
                 DElementStack.pop();
-                if(!WriteString("</")) {
-                    return false;
-                }
-                if(!WriteString(entity.DNameData)) {
-                    return false;
-                }
-                if(!WriteString(">")) {
-                    return false;
-                }
+                DSegments.push_back("</");
+                DSegments.push_back(entity.DNameData);
+                DSegments.push_back(">");
                 break;
                 
             case SXMLEntity::EType::CharData:
-                if(!WriteEscaped(entity.DNameData)) {
-                    return false;
-                }
+                AppendEscaped(entity.DNameData);
                 break;
                 
             case SXMLEntity::EType::CompleteElement:
-                if(!WriteString("<")) {
-                    return false;
-                }
-                if(!WriteString(entity.DNameData)) {
-                    return false;
-                }
-                for(const auto &attr : entity.DAttributes) {
-                    if(!WriteString(" ")) {
-                        return false;
-                    }
-                    if(!WriteString(attr.first)) {
-                        return false;
-                    }
-                    if(!WriteString("=\"")) {
-                        return false;
-                    }
-                    if(!WriteEscaped(attr.second)) {
-                        return false;
-                    }
-                    if(!WriteString("\"")) {
-                        return false;
-                    }
-                }
-                if(!WriteString("/>")) {
-                    return false;
-                }
+                AppendTag(entity, "/>");
                 break;
         }
+        if(!DDataSink->WriteV(DSegments.data(), DSegments.size())) {
+            return false;
+        }
+        if(entity.DType == SXMLEntity::EType::StartElement) {
+            DElementStack.push(entity.DNameData);
+        }
         return true;
     }
     
@@ -147,4 +113,4 @@ bool CXMLWriter::Flush() {
 
 bool CXMLWriter::WriteEntity(const SXMLEntity &entity) {
     return DImplementation->WriteEntity(entity);
-} 
\ No newline at end of file
+}
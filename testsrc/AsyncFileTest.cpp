@@ -0,0 +1,260 @@
+#include <gtest/gtest.h>
+#include "AsyncFileDataSource.h"
+#include "AsyncFileDataSink.h"
+#include "DSVReader.h"
+#include "IOUring.h"
+#include "TestFiles.h"
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+static std::string TestContents(){
+    std::string Contents;
+    for(int Index = 0; Index < 5000; Index++){
+        Contents += std::to_string(Index) + ",\"value\n" + std::to_string(Index) + "\"\n";
+    }
+    return Contents;
+}
+
+TEST(AsyncFileDataSource, MissingFileTest){
+    CAsyncFileDataSource Source("/tmp/this/file/does/not/exist");
+    char TempCh = 'x';
+
+    EXPECT_FALSE(Source.IsOpen());
+    EXPECT_TRUE(Source.End());
+    EXPECT_FALSE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'x');
+}
+
+TEST(AsyncFileDataSink, BadPathTest){
+    CAsyncFileDataSink Sink("/tmp/this/file/does/not/exist");
+
+    EXPECT_FALSE(Sink.IsOpen());
+    EXPECT_FALSE(Sink.Put('x'));
+}
+
+TEST(AsyncFileDataSink, RoundTripTest){
+    std::string Name = TempFileName();
+    std::string Contents = TestContents();
+    {
+        // Small blocks keep several writes in flight
+        CAsyncFileDataSink Sink(Name, true, 1000, 3);
+        std::vector<char> Buffer(Contents.begin(), Contents.begin() + 2500);
+
+        EXPECT_TRUE(Sink.IsOpen());
+        EXPECT_TRUE(Sink.Write(Buffer));
+        for(std::size_t Index = 2500; Index < Contents.size(); Index++){
+            EXPECT_TRUE(Sink.Put(Contents[Index]));
+        }
+        EXPECT_TRUE(Sink.Close());
+    }
+    CAsyncFileDataSource Source(Name, 1000, 3);
+    std::vector<char> Buffer;
+    std::string Result;
+
+    while(Source.Read(Buffer, 777)){
+        Result.append(Buffer.begin(), Buffer.end());
+    }
+    EXPECT_EQ(Result, Contents);
+    std::remove(Name.c_str());
+}
+
+TEST(AsyncFileDataSource, DSVTest){
+    std::string Name = TempFileName();
+    std::string Contents = TestContents();
+    {
+        CAsyncFileDataSink Sink(Name);
+        EXPECT_TRUE(Sink.Write(std::vector<char>(Contents.begin(), Contents.end())));
+    }
+    CDSVReader Reader(std::make_shared<CAsyncFileDataSource>(Name, 4096, 4), ',');
+    std::vector<std::string> Row;
+
+    for(int Index = 0; Index < 5000; Index++){
+        ASSERT_TRUE(Reader.ReadRow(Row));
+        ASSERT_EQ(Row.size(), 2);
+        EXPECT_EQ(Row[0], std::to_string(Index));
+        EXPECT_EQ(Row[1], "value\n" + std::to_string(Index));
+    }
+    EXPECT_TRUE(Reader.End());
+    std::remove(Name.c_str());
+}
+
+TEST(AsyncFileDataSource, EndKeepsViewTest){
+    std::string Name = CreateTempFile("aaaa\nbbbb\ncccc\n");
+    CAsyncFileDataSource Source(Name, 5, 2);
+    const char *Data;
+    std::size_t Length;
+
+    // End must not resubmit the viewed block for a later read
+    ASSERT_TRUE(Source.PeekBlock(Data, Length));
+    ASSERT_EQ(Length, 5);
+    EXPECT_EQ(Source.Consume(5), 5);
+    EXPECT_FALSE(Source.End());
+    ASSERT_TRUE(Source.PeekBlock(Data, Length));
+    EXPECT_EQ(std::string(Data, Length), "bbbb\n");
+    EXPECT_EQ(Source.Consume(5), 5);
+    EXPECT_FALSE(Source.End());
+    ASSERT_TRUE(Source.PeekBlock(Data, Length));
+    EXPECT_EQ(Source.Consume(5), 5);
+    EXPECT_TRUE(Source.End());
+    EXPECT_EQ(std::string(Data, 5), "cccc\n");
+    EXPECT_FALSE(Source.Error());
+
+    CDSVReader Reader(std::make_shared<CAsyncFileDataSource>(Name, 5, 2), ',');
+    std::vector<std::string_view> Row;
+    ASSERT_TRUE(Reader.ReadRowView(Row));
+    EXPECT_FALSE(Reader.End());
+    EXPECT_EQ(Row[0], "aaaa");
+    ASSERT_TRUE(Reader.ReadRowView(Row));
+    ASSERT_TRUE(Reader.ReadRowView(Row));
+    EXPECT_TRUE(Reader.End());
+    EXPECT_EQ(Row[0], "cccc");
+    std::remove(Name.c_str());
+}
+
+TEST(AsyncFileDataSource, PipeEndKeepsViewTest){
+    int Pipe[2];
+    ASSERT_EQ(pipe(Pipe), 0);
+    std::string Contents = "aaaa\nbbbb\ncccc\n";
+    ASSERT_EQ(write(Pipe[1], Contents.data(), Contents.size()), (ssize_t)Contents.size());
+    close(Pipe[1]);
+    auto Source = std::make_shared<CAsyncFileDataSource>("/dev/fd/" + std::to_string(Pipe[0]), 5, 4);
+    close(Pipe[0]);
+    CDSVReader Reader(Source, ',');
+    std::vector<std::string_view> Row;
+
+    ASSERT_TRUE(Reader.ReadRowView(Row));
+    EXPECT_FALSE(Reader.End());
+    EXPECT_EQ(Row[0], "aaaa");
+    ASSERT_TRUE(Reader.ReadRowView(Row));
+    EXPECT_FALSE(Reader.End());
+    EXPECT_EQ(Row[0], "bbbb");
+    ASSERT_TRUE(Reader.ReadRowView(Row));
+    EXPECT_TRUE(Reader.End());
+    EXPECT_EQ(Row[0], "cccc");
+    EXPECT_FALSE(Source->Error());
+}
+
+TEST(AsyncFileDataSource, ReadErrorTest){
+    // A directory opens but every read of it fails
+    CAsyncFileDataSource Source("/tmp");
+    char TempCh = 'x';
+
+    EXPECT_TRUE(Source.IsOpen());
+    EXPECT_FALSE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh, 'x');
+    EXPECT_TRUE(Source.End());
+    EXPECT_TRUE(Source.Error());
+    EXPECT_EQ(Source.ErrorNumber(), EISDIR);
+}
+
+TEST(AsyncFileDataSource, UnknownSizeTest){
+    // Files under /proc report a size of 0 but have content
+    CAsyncFileDataSource Proc("/proc/self/status");
+    std::vector<char> Contents;
+    ASSERT_TRUE(Proc.IsOpen());
+    EXPECT_FALSE(Proc.End());
+    EXPECT_TRUE(Proc.Read(Contents, 5));
+    EXPECT_EQ(std::string(Contents.data(), Contents.size()), "Name:");
+
+    // A file that grows after it is opened is read to its new end, whether
+    // the size at open falls inside a block or on a block boundary
+    for(std::size_t Size : {40, 32}){
+        std::string Initial(Size, 'a');
+        std::string Name = CreateTempFile(Initial);
+        CAsyncFileDataSource Source(Name, 16, 4);
+        {
+            std::ofstream Output(Name, std::ios::binary | std::ios::app);
+            Output << "grown";
+        }
+        std::string Read;
+        char TempCh;
+        while(!Source.End()){
+            EXPECT_TRUE(Source.Get(TempCh));
+            Read += TempCh;
+        }
+        EXPECT_EQ(Read, Initial + "grown");
+        EXPECT_FALSE(Source.Get(TempCh));
+        std::remove(Name.c_str());
+    }
+}
+
+TEST(IOUring, ReadWriteTest){
+    CIOUring Ring(4);
+    if(!Ring.IsOpen()){
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    std::string Name = TempFileName();
+    int FileDescriptor = open(Name.c_str(), O_RDWR);
+    ASSERT_GE(FileDescriptor, 0);
+    std::string Contents = "hello io_uring";
+    std::vector<char> Buffer(64, 0);
+    struct iovec Vector = {Buffer.data(), Buffer.size()};
+    uint64_t Data = 0;
+    int Result = 0;
+
+    ASSERT_TRUE(Ring.PrepareWrite(FileDescriptor, Contents.data(), Contents.size(), 0, -1, 7));
+    ASSERT_TRUE(Ring.Submit());
+    ASSERT_TRUE(Ring.WaitCompletion(Data, Result));
+    EXPECT_EQ(Data, 7);
+    EXPECT_EQ(Result, (int)Contents.size());
+
+    ASSERT_TRUE(Ring.RegisterBuffers(&Vector, 1));
+    ASSERT_TRUE(Ring.PrepareRead(FileDescriptor, Buffer.data(), Buffer.size(), 6, 0, 8));
+    // Waiting submits anything still queued
+    ASSERT_TRUE(Ring.WaitCompletion(Data, Result));
+    EXPECT_EQ(Data, 8);
+    ASSERT_EQ(Result, 8);
+    EXPECT_EQ(std::string(Buffer.data(), 8), "io_uring");
+
+    ASSERT_TRUE(Ring.PrepareRead(-1, Buffer.data(), Buffer.size(), 0, -1, 9));
+    ASSERT_TRUE(Ring.Submit());
+    ASSERT_TRUE(Ring.WaitCompletion(Data, Result));
+    EXPECT_EQ(Data, 9);
+    EXPECT_EQ(Result, -EBADF);
+
+    // Only as many requests as entries fit in the queue
+    for(int Index = 0; Index < 4; Index++){
+        EXPECT_TRUE(Ring.PrepareRead(FileDescriptor, Buffer.data(), 1, 0, -1, Index));
+    }
+    EXPECT_FALSE(Ring.PrepareRead(FileDescriptor, Buffer.data(), 1, 0, -1, 4));
+    ASSERT_TRUE(Ring.Submit());
+    for(int Index = 0; Index < 4; Index++){
+        ASSERT_TRUE(Ring.WaitCompletion(Data, Result));
+        EXPECT_EQ(Result, 1);
+    }
+    close(FileDescriptor);
+    std::remove(Name.c_str());
+}
+
+TEST(AsyncFileDataSource, LargeFileTest){
+    std::string Name = TempFileName();
+    std::string Contents;
+    for(int Index = 0; Index < 100000; Index++){
+        Contents += std::to_string(Index) + ",\"value\n" + std::to_string(Index) + "\"\n";
+    }
+    {
+        CAsyncFileDataSink Sink(Name, false, 64 * 1024, 4);
+        EXPECT_TRUE(Sink.Write(Contents.data(), Contents.size()));
+        EXPECT_TRUE(Sink.Close());
+        EXPECT_EQ(Sink.IsAsync(), CIOUring(1).IsOpen());
+    }
+    EXPECT_EQ(FileContents(Name), Contents);
+    auto Source = std::make_shared<CAsyncFileDataSource>(Name, 64 * 1024, 4);
+    EXPECT_EQ(Source->IsAsync(), CIOUring(1).IsOpen());
+    CDSVReader Reader(Source, ',');
+    std::vector<std::string_view> Row;
+
+    // Fields must survive End, which looks past the block they point into
+    for(int Index = 0; Index < 100000; Index++){
+        ASSERT_TRUE(Reader.ReadRowView(Row));
+        Reader.End();
+        ASSERT_EQ(Row.size(), 2);
+        ASSERT_EQ(Row[0], std::to_string(Index));
+        ASSERT_EQ(Row[1], "value\n" + std::to_string(Index));
+    }
+    EXPECT_TRUE(Reader.End());
+    EXPECT_FALSE(Source->Error());
+    std::remove(Name.c_str());
+}
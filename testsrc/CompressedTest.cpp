@@ -0,0 +1,269 @@
+#include <gtest/gtest.h>
+#include "CompressedDataSource.h"
+#include "CompressedDataSink.h"
+#include "StringDataSource.h"
+#include "StringDataSink.h"
+#include "DSVReader.h"
+#include "XMLReader.h"
+
+static std::string TestContents(){
+    std::string Contents;
+    for(int Index = 0; Index < 5000; Index++){
+        Contents += std::to_string(Index) + ",\"value\n" + std::to_string(Index) + "\"\n";
+    }
+    return Contents;
+}
+
+static std::string Compress(const std::string &contents, CCompressedDataSink::EFormat format){
+    auto Sink = std::make_shared<CStringDataSink>();
+    {
+        // A small block size makes the stream span many compress calls
+        CCompressedDataSink Compressor(Sink, format, -1, 1000);
+        if(!Compressor.IsOpen() || !Compressor.Write(std::vector<char>(contents.begin(), contents.end()))){
+            return std::string();
+        }
+    }
+    return Sink->String();
+}
+
+static std::string Decompress(const std::string &data){
+    CCompressedDataSource Source(std::make_shared<CStringDataSource>(data), 999);
+    std::vector<char> Buffer;
+    std::string Result;
+    while(Source.Read(Buffer, 1234)){
+        Result.append(Buffer.begin(), Buffer.end());
+    }
+    return Result;
+}
+
+TEST(CompressedDataSource, PlainTest){
+    CCompressedDataSource Source(std::make_shared<CStringDataSource>("Hello World"));
+    const char *Data;
+    std::size_t Length;
+    char TempCh;
+
+    EXPECT_EQ(Source.Format(), CCompressedDataSource::EFormat::Plain);
+    EXPECT_TRUE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'H');
+    EXPECT_TRUE(Source.PeekBlock(Data,Length));
+    EXPECT_EQ(std::string(Data,Length),"ell");
+    EXPECT_EQ(Source.Consume(5),5);
+    EXPECT_TRUE(Source.PeekBlock(Data,Length));
+    EXPECT_EQ(std::string(Data,Length),"World");
+    EXPECT_EQ(Decompress("x"),"x");
+    EXPECT_EQ(Decompress(""),"");
+}
+
+TEST(CompressedDataSource, GzipTest){
+    std::string Contents = TestContents();
+    std::string Compressed = Compress(Contents, CCompressedDataSink::EFormat::Gzip);
+    CCompressedDataSource Source(std::make_shared<CStringDataSource>(Compressed));
+
+    EXPECT_LT(Compressed.size(), Contents.size());
+    EXPECT_EQ(Source.Format(), CCompressedDataSource::EFormat::Gzip);
+    EXPECT_EQ(Decompress(Compressed), Contents);
+    // Concatenated gzip members decode as one stream
+    EXPECT_EQ(Decompress(Compressed + Compressed), Contents + Contents);
+}
+
+TEST(CompressedDataSource, ZlibTest){
+    std::string Contents = TestContents();
+    std::string Compressed = Compress(Contents, CCompressedDataSink::EFormat::Zlib);
+    CCompressedDataSource Source(std::make_shared<CStringDataSource>(Compressed));
+
+    EXPECT_EQ(Source.Format(), CCompressedDataSource::EFormat::Zlib);
+    EXPECT_EQ(Decompress(Compressed), Contents);
+}
+
+#ifdef HAVE_ZSTD
+TEST(CompressedDataSource, ZstdTest){
+    std::string Contents = TestContents();
+    std::string Compressed = Compress(Contents, CCompressedDataSink::EFormat::Zstd);
+    CCompressedDataSource Source(std::make_shared<CStringDataSource>(Compressed));
+
+    EXPECT_LT(Compressed.size(), Contents.size());
+    EXPECT_EQ(Source.Format(), CCompressedDataSource::EFormat::Zstd);
+    EXPECT_EQ(Decompress(Compressed), Contents);
+    // Concatenated frames decode as one stream
+    EXPECT_EQ(Decompress(Compressed + Compressed), Contents + Contents);
+
+    CCompressedDataSource Truncated(std::make_shared<CStringDataSource>(Compressed.substr(0, Compressed.size() / 2)));
+    std::vector<char> Buffer;
+    while(Truncated.Read(Buffer, 1000)){
+    }
+    EXPECT_TRUE(Truncated.End());
+    EXPECT_TRUE(Truncated.Error());
+
+    CDSVReader Reader(std::make_shared<CCompressedDataSource>(std::make_shared<CStringDataSource>(Compressed), 100), ',');
+    std::vector<std::string_view> Row;
+    for(int Index = 0; Index < 5000; Index++){
+        ASSERT_TRUE(Reader.ReadRowView(Row));
+        Reader.End();
+        ASSERT_EQ(Row.size(), 2);
+        ASSERT_EQ(Row[0], std::to_string(Index));
+        ASSERT_EQ(Row[1], "value\n" + std::to_string(Index));
+    }
+    EXPECT_TRUE(Reader.End());
+}
+#else
+TEST(CompressedDataSource, ZstdUnavailableTest){
+    // Without zstd a frame is reported as an error rather than passed through
+    CCompressedDataSource Source(std::make_shared<CStringDataSource>(std::string("\x28\xb5\x2f\xfd\x00", 5)));
+    char TempCh;
+
+    EXPECT_EQ(Source.Format(), CCompressedDataSource::EFormat::Zstd);
+    EXPECT_FALSE(Source.Get(TempCh));
+    EXPECT_TRUE(Source.Error());
+    EXPECT_FALSE(CCompressedDataSink(std::make_shared<CStringDataSink>(), CCompressedDataSink::EFormat::Zstd).IsOpen());
+}
+#endif
+
+TEST(CompressedDataSource, ZlibLookalikeTest){
+    std::string Long = "x^";
+    for(int Index = 0; Index < 20000; Index++){
+        Long += "line " + std::to_string(Index) + "\n";
+    }
+    std::string Binary("x\x01\x02\x03 plain", 11);
+
+    // Text with a valid looking zlib header passes through when inflating fails
+    for(const std::string &Text : {std::string("x^ marks the spot"), std::string("HK"), Binary, Long}){
+        CCompressedDataSource Source(std::make_shared<CStringDataSource>(Text), 999);
+        std::vector<char> Buffer;
+        std::string Result;
+
+        EXPECT_EQ(Source.Format(), CCompressedDataSource::EFormat::Zlib);
+        while(Source.Read(Buffer, 1234)){
+            Result.append(Buffer.begin(), Buffer.end());
+        }
+        EXPECT_EQ(Result, Text);
+        EXPECT_EQ(Source.Format(), CCompressedDataSource::EFormat::Plain);
+        EXPECT_FALSE(Source.Error());
+        EXPECT_TRUE(Source.End());
+    }
+    // A preset dictionary or a window over 32 KB is not a zlib header
+    CCompressedDataSource Dictionary(std::make_shared<CStringDataSource>("x\xbb"));
+    EXPECT_EQ(Dictionary.Format(), CCompressedDataSource::EFormat::Plain);
+    CCompressedDataSource Window(std::make_shared<CStringDataSource>("\x88\x1c"));
+    EXPECT_EQ(Window.Format(), CCompressedDataSource::EFormat::Plain);
+
+    CDSVReader Reader(std::make_shared<CCompressedDataSource>(std::make_shared<CStringDataSource>("x^,y\n1,2\n"), 4), ',');
+    std::vector<std::string_view> Row;
+    ASSERT_TRUE(Reader.ReadRowView(Row));
+    ASSERT_EQ(Row.size(), 2);
+    EXPECT_EQ(Row[0], "x^");
+    ASSERT_TRUE(Reader.ReadRowView(Row));
+    EXPECT_EQ(Row[1], "2");
+    EXPECT_TRUE(Reader.End());
+}
+
+TEST(CompressedDataSource, TruncatedTest){
+    std::string Compressed = Compress(TestContents(), CCompressedDataSink::EFormat::Gzip);
+    CCompressedDataSource Source(std::make_shared<CStringDataSource>(Compressed.substr(0, Compressed.size() / 2)));
+    std::vector<char> Buffer;
+
+    while(Source.Read(Buffer, 1000)){
+    }
+    EXPECT_TRUE(Source.End());
+    EXPECT_TRUE(Source.Error());
+}
+
+TEST(CompressedDataSource, DSVTest){
+    std::string Compressed = Compress(TestContents(), CCompressedDataSink::EFormat::Gzip);
+    CDSVReader Reader(std::make_shared<CCompressedDataSource>(std::make_shared<CStringDataSource>(Compressed), 100), ',');
+    std::vector<std::string> Row;
+
+    for(int Index = 0; Index < 5000; Index++){
+        ASSERT_TRUE(Reader.ReadRow(Row));
+        ASSERT_EQ(Row.size(), 2);
+        EXPECT_EQ(Row[0], std::to_string(Index));
+        EXPECT_EQ(Row[1], "value\n" + std::to_string(Index));
+    }
+    EXPECT_TRUE(Reader.End());
+}
+
+TEST(CompressedDataSource, EndKeepsViewTest){
+    std::string Compressed = Compress("aaaa\nbbbb\ncccc\n", CCompressedDataSink::EFormat::Gzip);
+    CCompressedDataSource Source(std::make_shared<CStringDataSource>(Compressed), 5);
+    const char *Data;
+    std::size_t Length;
+
+    // End decodes ahead without overwriting the viewed block
+    ASSERT_TRUE(Source.PeekBlock(Data, Length));
+    ASSERT_EQ(Length, 5);
+    EXPECT_EQ(Source.Consume(5), 5);
+    EXPECT_FALSE(Source.End());
+    EXPECT_EQ(std::string(Data, 5), "aaaa\n");
+    ASSERT_TRUE(Source.PeekBlock(Data, Length));
+    EXPECT_EQ(std::string(Data, Length), "bbbb\n");
+
+    CDSVReader Reader(std::make_shared<CCompressedDataSource>(std::make_shared<CStringDataSource>(Compressed), 5), ',');
+    std::vector<std::string_view> Row;
+    ASSERT_TRUE(Reader.ReadRowView(Row));
+    EXPECT_FALSE(Reader.End());
+    EXPECT_EQ(Row[0], "aaaa");
+    ASSERT_TRUE(Reader.ReadRowView(Row));
+    ASSERT_TRUE(Reader.ReadRowView(Row));
+    EXPECT_TRUE(Reader.End());
+    EXPECT_EQ(Row[0], "cccc");
+}
+
+TEST(CompressedDataSource, LargeXMLTest){
+    std::string Document = "<root>";
+    for(int Index = 0; Index < 40000; Index++){
+        Document += "<item id=\"" + std::to_string(Index) + "\">value &amp; " + std::to_string(Index) + "</item>\n";
+    }
+    Document += "</root>";
+    ASSERT_GT(Document.size(), 1024 * 1024);
+    std::string Compressed = Compress(Document, CCompressedDataSink::EFormat::Gzip);
+    // Blocks of 64 KB and more are handed to the reader whole
+    CXMLReader Reader(std::make_shared<CCompressedDataSource>(std::make_shared<CStringDataSource>(Compressed), 64 * 1024));
+    CXMLReader Expected(std::make_shared<CStringDataSource>(Document));
+    SXMLEntity Entity, ExpectedEntity;
+    std::size_t Count = 0;
+
+    while(Expected.ReadEntity(ExpectedEntity)){
+        ASSERT_TRUE(Reader.ReadEntity(Entity));
+        ASSERT_EQ(Entity.DNameData, ExpectedEntity.DNameData);
+        ASSERT_EQ(Entity.DAttributes, ExpectedEntity.DAttributes);
+        Count++;
+    }
+    EXPECT_FALSE(Reader.ReadEntity(Entity));
+    EXPECT_TRUE(Reader.End());
+    EXPECT_EQ(Count, 120002);
+}
+
+TEST(CompressedDataSource, LargeRowViewTest){
+    std::string Input;
+    for(int Index = 0; Index < 50000; Index++){
+        Input += std::to_string(Index) + ",value " + std::to_string(Index) + ",\"quoted\n" + std::to_string(Index) + "\"\n";
+    }
+    ASSERT_GT(Input.size(), 1024 * 1024);
+    auto Source = std::make_shared<CCompressedDataSource>(std::make_shared<CStringDataSource>(Compress(Input, CCompressedDataSink::EFormat::Zlib)), 64 * 1024);
+    CDSVReader Reader(Source, ',');
+    std::vector<std::string_view> Row;
+
+    // Fields must survive End, which decodes past the block they point into
+    for(int Index = 0; Index < 50000; Index++){
+        ASSERT_TRUE(Reader.ReadRowView(Row));
+        Reader.End();
+        ASSERT_EQ(Row.size(), 3);
+        ASSERT_EQ(Row[0], std::to_string(Index));
+        ASSERT_EQ(Row[1], "value " + std::to_string(Index));
+        ASSERT_EQ(Row[2], "quoted\n" + std::to_string(Index));
+    }
+    EXPECT_TRUE(Reader.End());
+    EXPECT_FALSE(Source->Error());
+}
+
+TEST(CompressedDataSink, FlushTest){
+    auto Sink = std::make_shared<CStringDataSink>();
+    CCompressedDataSink Compressor(Sink);
+
+    EXPECT_TRUE(Compressor.Put('a'));
+    EXPECT_TRUE(Compressor.Flush());
+    EXPECT_EQ(Decompress(Sink->String() + std::string()), "a");
+    EXPECT_TRUE(Compressor.Close());
+    EXPECT_FALSE(Compressor.IsOpen());
+    EXPECT_FALSE(Compressor.Put('b'));
+    EXPECT_EQ(Decompress(Sink->String()), "a");
+}
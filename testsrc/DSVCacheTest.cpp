@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+#include "DSVCache.h"
+#include "DSVReader.h"
+#include "StringDataSource.h"
+#include "TestFiles.h"
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <thread>
+
+static std::vector<std::vector<std::string>> ParsedRows(const std::string &contents, char delimiter){
+    CDSVReader Reader(std::make_shared<CStringDataSource>(contents), delimiter);
+    std::vector<std::vector<std::string>> Rows;
+    std::vector<std::string> Row;
+    while(Reader.ReadRow(Row)){
+        Rows.push_back(Row);
+    }
+    return Rows;
+}
+
+static std::vector<std::vector<std::string>> CachedRows(CDSVCacheReader &reader){
+    std::vector<std::vector<std::string>> Rows;
+    std::vector<std::string> Row;
+    while(reader.ReadRow(Row)){
+        Rows.push_back(Row);
+    }
+    return Rows;
+}
+
+TEST(DSVCache, RoundTripTest){
+    // Integers that do not print back the same, a repeated column, quoting and
+    // ragged rows must all read back exactly
+    std::string Input = "id,kind,note,count\n"
+                        "1,red,\"a,b\",007\n"
+                        "-2,red,\"multi\nline\",+3\n"
+                        "9223372036854775807,blue,\"say \"\"hi\"\"\",-0\n"
+                        "4,red\n"
+                        "5,blue,,,extra\n"
+                        "\n"
+                        "-9223372036854775808,red,x,12\n";
+    std::string DSVName = CreateTempFile(Input);
+    std::string CacheName = DSVName + ".cache";
+    std::remove(CacheName.c_str());
+
+    CDSVCacheReader Reader(DSVName, ',', CacheName);
+    EXPECT_TRUE(Reader.IsOpen());
+    EXPECT_FALSE(Reader.FromCache());
+    EXPECT_EQ(Reader.RowCount(), 8);
+    EXPECT_EQ(CachedRows(Reader), ParsedRows(Input, ','));
+    EXPECT_TRUE(Reader.End());
+    EXPECT_TRUE(CDSVCache::Valid(DSVName, ',', CacheName));
+    EXPECT_FALSE(CDSVCache::Valid(DSVName, '\t', CacheName));
+
+    CDSVCacheReader Cached(DSVName, ',', CacheName);
+    std::vector<std::string_view> Row;
+    EXPECT_TRUE(Cached.FromCache());
+    EXPECT_EQ(CachedRows(Cached), ParsedRows(Input, ','));
+    EXPECT_TRUE(Cached.SeekRow(3));
+    EXPECT_TRUE(Cached.ReadRowView(Row));
+    ASSERT_EQ(Row.size(), 4);
+    EXPECT_EQ(Row[0], "9223372036854775807");
+    EXPECT_EQ(Row[2], "say \"hi\"");
+    EXPECT_EQ(Row[3], "-0");
+    EXPECT_TRUE(Cached.SeekRow(8));
+    EXPECT_TRUE(Cached.End());
+    EXPECT_FALSE(Cached.ReadRowView(Row));
+    EXPECT_FALSE(Cached.SeekRow(9));
+
+    std::remove(DSVName.c_str());
+    std::remove(CacheName.c_str());
+}
+
+TEST(DSVCache, EmptyTest){
+    std::string DSVName = CreateTempFile("");
+    std::string CacheName = DSVName + ".cache";
+    std::vector<std::string> Row;
+
+    EXPECT_TRUE(CDSVCache::Build(DSVName, ',', CacheName));
+    CDSVCacheReader Reader(DSVName, ',', CacheName);
+    EXPECT_TRUE(Reader.IsOpen());
+    EXPECT_TRUE(Reader.FromCache());
+    EXPECT_EQ(Reader.RowCount(), 0);
+    EXPECT_TRUE(Reader.End());
+    EXPECT_FALSE(Reader.ReadRow(Row));
+
+    std::remove(DSVName.c_str());
+    std::remove(CacheName.c_str());
+}
+
+TEST(DSVCache, InvalidationTest){
+    std::string DSVName = CreateTempFile("a,1\nb,2\n");
+    std::string CacheName = DSVName + ".cache";
+    std::remove(CacheName.c_str());
+
+    EXPECT_FALSE(CDSVCache::Valid(DSVName, ',', CacheName));
+    EXPECT_TRUE(CDSVCache::Build(DSVName, ',', CacheName));
+    EXPECT_TRUE(CDSVCache::Valid(DSVName, ',', CacheName));
+
+    // A different size invalidates the cache
+    WriteFile(DSVName, "a,1\nb,2\nc,3\n");
+    EXPECT_FALSE(CDSVCache::Valid(DSVName, ',', CacheName));
+    {
+        CDSVCacheReader Reader(DSVName, ',', CacheName);
+        EXPECT_FALSE(Reader.FromCache());
+        EXPECT_EQ(Reader.RowCount(), 3);
+    }
+    EXPECT_TRUE(CDSVCache::Valid(DSVName, ',', CacheName));
+
+    // So does the same size with a new modification time
+    WriteFile(DSVName, "x,1\ny,2\nz,3\n");
+    struct timespec Times[2] = {{0, UTIME_OMIT}, {1000000, 0}};
+    EXPECT_EQ(utimensat(AT_FDCWD, DSVName.c_str(), Times, 0), 0);
+    EXPECT_FALSE(CDSVCache::Valid(DSVName, ',', CacheName));
+    {
+        CDSVCacheReader Reader(DSVName, ',', CacheName);
+        std::vector<std::string> Row;
+        EXPECT_FALSE(Reader.FromCache());
+        EXPECT_TRUE(Reader.ReadRow(Row));
+        EXPECT_EQ(Row, std::vector<std::string>({"x", "1"}));
+    }
+
+    std::remove(DSVName.c_str());
+    std::remove(CacheName.c_str());
+}
+
+TEST(DSVCache, CorruptTest){
+    std::string Input;
+    for(int Index = 0; Index < 100; Index++){
+        Input += std::to_string(Index) + ",name" + std::to_string(Index % 7) + "\n";
+    }
+    std::string DSVName = CreateTempFile(Input);
+    std::string CacheName = DSVName + ".cache";
+    EXPECT_TRUE(CDSVCache::Build(DSVName, ',', CacheName));
+
+    std::string Image = FileContents(CacheName);
+    ASSERT_GT(Image.size(), 200);
+    Image[Image.size() - 100] ^= 1;
+    WriteFile(CacheName, Image);
+    EXPECT_FALSE(CDSVCache::Valid(DSVName, ',', CacheName));
+    WriteFile(CacheName, Image.substr(0, 40));
+    EXPECT_FALSE(CDSVCache::Valid(DSVName, ',', CacheName));
+
+    CDSVCacheReader Reader(DSVName, ',', CacheName);
+    EXPECT_FALSE(Reader.FromCache());
+    EXPECT_EQ(CachedRows(Reader), ParsedRows(Input, ','));
+    EXPECT_TRUE(CDSVCache::Valid(DSVName, ',', CacheName));
+
+    std::remove(DSVName.c_str());
+    std::remove(CacheName.c_str());
+}
+
+TEST(DSVCache, ConcurrentBuildTest){
+    std::string Input;
+    for(int Index = 0; Index < 20000; Index++){
+        Input += std::to_string(Index) + ",name" + std::to_string(Index % 7) + ",text " + std::to_string(Index * 31) + "\n";
+    }
+    std::string DSVName = CreateTempFile(Input);
+    std::string CacheName = DSVName + ".cache";
+
+    bool Built[4];
+    std::vector<std::thread> Threads;
+    for(int Index = 0; Index < 4; Index++){
+        Threads.emplace_back([&, Index]{
+            Built[Index] = CDSVCache::Build(DSVName, ',', CacheName);
+        });
+    }
+    for(auto &Thread : Threads){
+        Thread.join();
+    }
+    for(bool Result : Built){
+        EXPECT_TRUE(Result);
+    }
+    EXPECT_TRUE(CDSVCache::Valid(DSVName, ',', CacheName));
+    CDSVCacheReader Reader(DSVName, ',', CacheName);
+    EXPECT_TRUE(Reader.FromCache());
+    EXPECT_EQ(CachedRows(Reader), ParsedRows(Input, ','));
+
+    std::remove(DSVName.c_str());
+    std::remove(CacheName.c_str());
+}
+
+TEST(DSVCache, UnwritableCacheTest){
+    std::string Input = "a\tb\n1\t2\n";
+    std::string DSVName = CreateTempFile(Input);
+    std::string CacheName = "/tmp/this/dir/does/not/exist.cache";
+
+    EXPECT_FALSE(CDSVCache::Build(DSVName, '\t', CacheName));
+    CDSVCacheReader Reader(DSVName, '\t', CacheName);
+    EXPECT_TRUE(Reader.IsOpen());
+    EXPECT_FALSE(Reader.FromCache());
+    EXPECT_EQ(CachedRows(Reader), ParsedRows(Input, '\t'));
+
+    CDSVCacheReader Missing("/tmp/this/file/does/not/exist.csv", ',', CacheName);
+    EXPECT_FALSE(Missing.IsOpen());
+    EXPECT_TRUE(Missing.End());
+
+    std::remove(DSVName.c_str());
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include "DSVColumnReader.h"
+#include "StringDataSource.h"
+#include <cmath>
+
+using EType = SDSVColumn::EType;
+
+TEST(DSVColumnReader, TypesTest){
+    auto Source = std::make_shared<CStringDataSource>("1,2.5,true,abc\n-9,1e3,0,\"x,\"\"y\"\"\"\n");
+    CDSVColumnReader Reader(Source, ',', {EType::Int64, EType::Double, EType::Bool, EType::String});
+    SDSVColumnBatch Batch;
+
+    EXPECT_TRUE(Reader.ReadBatch(Batch, 10));
+    ASSERT_EQ(Batch.DRowCount, 2);
+    ASSERT_EQ(Batch.DColumns.size(), 4);
+    EXPECT_EQ(Batch.DColumns[0].DInt64, std::vector<std::int64_t>({1, -9}));
+    EXPECT_EQ(Batch.DColumns[1].DDouble, std::vector<double>({2.5, 1000.0}));
+    EXPECT_EQ(Batch.DColumns[2].DBool, std::vector<std::uint8_t>({1, 0}));
+    EXPECT_EQ(Batch.DColumns[3].StringValue(0), "abc");
+    EXPECT_EQ(Batch.DColumns[3].StringValue(1), "x,\"y\"");
+    EXPECT_EQ(Batch.DColumns[3].DBytes, "abcx,\"y\"");
+    for(auto &Column : Batch.DColumns){
+        EXPECT_EQ(Column.DValid, std::vector<std::uint8_t>({1, 1}));
+    }
+    EXPECT_TRUE(Reader.End());
+    EXPECT_FALSE(Reader.ReadBatch(Batch, 10));
+    EXPECT_EQ(Batch.DRowCount, 0);
+}
+
+TEST(DSVColumnReader, InvalidTest){
+    auto Source = std::make_shared<CStringDataSource>("12x, 3,maybe\n,nan,FALSE\n7\n");
+    CDSVColumnReader Reader(Source, ',', {EType::Int64, EType::Double, EType::Bool, EType::String});
+    SDSVColumnBatch Batch;
+
+    EXPECT_TRUE(Reader.ReadBatch(Batch, 10));
+    ASSERT_EQ(Batch.DRowCount, 3);
+    EXPECT_EQ(Batch.DColumns[0].DInt64, std::vector<std::int64_t>({0, 0, 7}));
+    EXPECT_EQ(Batch.DColumns[0].DValid, std::vector<std::uint8_t>({0, 0, 1}));
+    EXPECT_EQ(Batch.DColumns[1].DValid, std::vector<std::uint8_t>({0, 1, 0}));
+    EXPECT_TRUE(std::isnan(Batch.DColumns[1].DDouble[1]));
+    EXPECT_EQ(Batch.DColumns[2].DBool, std::vector<std::uint8_t>({0, 0, 0}));
+    EXPECT_EQ(Batch.DColumns[2].DValid, std::vector<std::uint8_t>({0, 1, 0}));
+    EXPECT_EQ(Batch.DColumns[3].DValid, std::vector<std::uint8_t>({0, 0, 0}));
+    EXPECT_EQ(Batch.DColumns[3].StringValue(2), "");
+}
+
+TEST(DSVColumnReader, BatchTest){
+    std::string Input;
+    for(int Index = 0; Index < 25; Index++){
+        Input += std::to_string(Index) + "," + std::to_string(Index) + "s\n";
+    }
+    CDSVColumnReader Reader(std::make_shared<CStringDataSource>(Input), ',', {EType::Int64, EType::String});
+    SDSVColumnBatch Batch;
+    std::int64_t Expected = 0;
+
+    while(Reader.ReadBatch(Batch, 10)){
+        EXPECT_EQ(Batch.DRowCount, Expected < 20 ? 10 : 5);
+        const std::int64_t *Values = Batch.DColumns[0].DInt64.data();
+        for(std::size_t Row = 0; Row < Batch.DRowCount; Row++, Expected++){
+            EXPECT_EQ(Values[Row], Expected);
+            EXPECT_EQ(Batch.DColumns[1].StringValue(Row), std::to_string(Expected) + "s");
+        }
+    }
+    EXPECT_EQ(Expected, 25);
+}
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+#include "DSVHeaderReader.h"
+#include "StringDataSource.h"
+
+TEST(DSVHeaderReader, EmptyTest){
+    CDSVHeaderReader Reader(std::make_shared<CStringDataSource>(""), ',');
+    std::vector<std::string> Row;
+
+    EXPECT_TRUE(Reader.Header().empty());
+    EXPECT_EQ(Reader.Column("a"), CDSVHeaderReader::NoColumn);
+    EXPECT_TRUE(Reader.End());
+    EXPECT_FALSE(Reader.ReadRow(Row));
+    EXPECT_EQ(Reader.Field("a"), "");
+}
+
+TEST(DSVHeaderReader, LookupTest){
+    auto Source = std::make_shared<CStringDataSource>("id,\"full,name\",age,id\n1,\"Bob \"\"B\"\"\",30,x\n2,Al\n");
+    CDSVHeaderReader Reader(Source, ',');
+    std::vector<std::string_view> Row;
+
+    ASSERT_EQ(Reader.Header().size(), 4);
+    EXPECT_EQ(Reader.Header()[1], "full,name");
+    EXPECT_EQ(Reader.Column("id"), 0);
+    EXPECT_EQ(Reader.Column("full,name"), 1);
+    EXPECT_EQ(Reader.Column("age"), 2);
+    EXPECT_EQ(Reader.Column("missing"), CDSVHeaderReader::NoColumn);
+    EXPECT_TRUE(Reader.ReadRowView(Row));
+    ASSERT_EQ(Row.size(), 4);
+    EXPECT_EQ(Reader.Field("full,name"), "Bob \"B\"");
+    EXPECT_EQ(Reader.Field("age"), "30");
+    EXPECT_EQ(Reader.Field(3), "x");
+    EXPECT_EQ(Reader.Field("missing"), "");
+    EXPECT_TRUE(Reader.ReadRowView(Row));
+    EXPECT_EQ(Reader.Field("id"), "2");
+    EXPECT_EQ(Reader.Field("age"), "");
+    EXPECT_TRUE(Reader.End());
+}
+
+TEST(DSVHeaderReader, ManyColumnsTest){
+    std::string Header, Values;
+    for(int Index = 0; Index < 500; Index++){
+        Header += (Index ? "," : "") + std::string("column") + std::to_string(Index);
+        Values += (Index ? "," : "") + std::to_string(Index * 3);
+    }
+    CDSVHeaderReader Reader(std::make_shared<CStringDataSource>(Header + "\n" + Values + "\n"), ',');
+    std::vector<std::string> Row;
+
+    EXPECT_TRUE(Reader.ReadRow(Row));
+    for(int Index = 0; Index < 500; Index++){
+        std::string Name = "column" + std::to_string(Index);
+        EXPECT_EQ(Reader.Column(Name), Index);
+        EXPECT_EQ(Reader.Field(Name), std::to_string(Index * 3));
+    }
+    EXPECT_EQ(Reader.Column("column500"), CDSVHeaderReader::NoColumn);
+}
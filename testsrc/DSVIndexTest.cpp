@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include "DSVIndex.h"
+#include "DSVReader.h"
+#include "FileDataSource.h"
+#include "StringDataSink.h"
+#include "StringDataSource.h"
+#include "TestFiles.h"
+#include <cstdio>
+
+static std::string Rows(std::size_t count){
+    std::string Input;
+    for(std::size_t Index = 0; Index < count; Index++){
+        // Every third row has a quoted newline to throw off naive line counting
+        Input += std::to_string(Index) + (Index % 3 ? ",plain\n" : ",\"multi\nline\"\n");
+    }
+    return Input;
+}
+
+TEST(DSVIndex, BuildTest){
+    CDSVIndex Index(4);
+    Index.Build(std::make_shared<CStringDataSource>("a\n\"b\nc\"\n\nd,e\nf"), ',');
+    std::uint64_t Offset;
+    std::size_t Skip;
+
+    EXPECT_EQ(Index.RowCount(), 5);
+    EXPECT_EQ(Index.DataSize(), 14);
+    EXPECT_TRUE(Index.Locate(3, Offset, Skip));
+    EXPECT_EQ(Offset, 0);
+    EXPECT_EQ(Skip, 3);
+    EXPECT_TRUE(Index.Locate(4, Offset, Skip));
+    EXPECT_EQ(Offset, 13);
+    EXPECT_EQ(Skip, 0);
+    EXPECT_TRUE(Index.Locate(5, Offset, Skip));
+    EXPECT_EQ(Offset, 14);
+    EXPECT_FALSE(Index.Locate(6, Offset, Skip));
+}
+
+TEST(DSVIndex, SaveLoadTest){
+    CDSVIndex Index(7);
+    Index.Build(std::make_shared<CStringDataSource>(Rows(100)), ',');
+    auto Sink = std::make_shared<CStringDataSink>();
+    CDSVIndex Loaded;
+    std::uint64_t Offset, LoadedOffset;
+    std::size_t Skip, LoadedSkip;
+
+    EXPECT_TRUE(Index.Save(Sink));
+    EXPECT_LT(Sink->String().size(), 64);
+    EXPECT_TRUE(Loaded.Load(std::make_shared<CStringDataSource>(Sink->String())));
+    EXPECT_EQ(Loaded.Interval(), 7);
+    EXPECT_EQ(Loaded.RowCount(), 100);
+    EXPECT_EQ(Loaded.DataSize(), Index.DataSize());
+    for(std::size_t Row = 0; Row <= 100; Row++){
+        EXPECT_TRUE(Index.Locate(Row, Offset, Skip));
+        EXPECT_TRUE(Loaded.Locate(Row, LoadedOffset, LoadedSkip));
+        EXPECT_EQ(Offset, LoadedOffset);
+        EXPECT_EQ(Skip, LoadedSkip);
+    }
+    EXPECT_FALSE(Loaded.Load(std::make_shared<CStringDataSource>(Sink->String().substr(0, Sink->String().size() - 1))));
+    EXPECT_FALSE(Loaded.Load(std::make_shared<CStringDataSource>("not an index")));
+    // A row count near the limit must not wrap around to an empty index
+    std::string Huge = std::string("DSVIDX1\n") + "\x02" + std::string(9, '\xff') + "\x01" + "\x00" + "\x00";
+    EXPECT_FALSE(Loaded.Load(std::make_shared<CStringDataSource>(Huge)));
+    EXPECT_EQ(Loaded.RowCount(), 100);
+}
+
+TEST(DSVIndexedReader, SeekRowTest){
+    std::string Input = Rows(50);
+    auto Index = std::make_shared<CDSVIndex>(8);
+    Index->Build(std::make_shared<CStringDataSource>(Input), ',');
+    CDSVIndexedReader Reader(std::make_shared<CStringDataSource>(Input), ',', Index);
+    std::vector<std::string> Row;
+
+    for(std::size_t Target : {37, 0, 8, 15, 16, 49}){
+        EXPECT_TRUE(Reader.SeekRow(Target));
+        EXPECT_EQ(Reader.Row(), Target);
+        EXPECT_TRUE(Reader.ReadRow(Row));
+        ASSERT_EQ(Row.size(), 2);
+        EXPECT_EQ(Row[0], std::to_string(Target));
+        EXPECT_EQ(Row[1], Target % 3 ? "plain" : "multi\nline");
+        EXPECT_EQ(Reader.Row(), Target + 1);
+    }
+    EXPECT_TRUE(Reader.End());
+    EXPECT_TRUE(Reader.SeekRow(50));
+    EXPECT_TRUE(Reader.End());
+    EXPECT_FALSE(Reader.SeekRow(51));
+}
+
+TEST(DSVIndexedReader, StaleIndexTest){
+    std::string Input = Rows(50);
+    auto Index = std::make_shared<CDSVIndex>(8);
+    Index->Build(std::make_shared<CStringDataSource>(Input), ',');
+    std::vector<std::string> Row;
+
+    // Grown, shrunk, or shifted by an edit that kept the size
+    for(const std::string &Changed : {Input + Rows(1), Input.substr(0, Input.size() - 1), "0" + Input.substr(0, Input.size() - 1)}){
+        CDSVIndexedReader Reader(std::make_shared<CStringDataSource>(Changed), ',', Index);
+        EXPECT_FALSE(Reader.SeekRow(16));
+    }
+    CDSVIndexedReader Reader(std::make_shared<CStringDataSource>(Input), ',', Index);
+    EXPECT_TRUE(Reader.SeekRow(16));
+    EXPECT_TRUE(Reader.ReadRow(Row));
+    EXPECT_EQ(Row[0], "16");
+}
+
+TEST(DSVIndexedReader, FailedSeekTest){
+    std::string Input = Rows(3);
+    auto Index = std::make_shared<CDSVIndex>(2);
+    Index->Build(std::make_shared<CStringDataSource>(Input), ',');
+    std::vector<std::string> Row;
+
+    // A failed seek leaves the reader where it was
+    CDSVIndexedReader Reader(std::make_shared<CStringDataSource>(Input), ',', Index);
+    EXPECT_FALSE(Reader.SeekRow(10));
+    EXPECT_TRUE(Reader.ReadRow(Row));
+    EXPECT_EQ(Row[0], "0");
+    EXPECT_EQ(Reader.Row(), 1);
+    EXPECT_FALSE(Reader.SeekRow(4));
+    EXPECT_TRUE(Reader.ReadRow(Row));
+    EXPECT_EQ(Row[0], "1");
+    EXPECT_EQ(Reader.Row(), 2);
+
+    // So does one refused because the index is stale
+    std::string Shifted = "0" + Input.substr(0, Input.size() - 1);
+    CDSVIndexedReader Stale(std::make_shared<CStringDataSource>(Shifted), ',', Index);
+    EXPECT_TRUE(Stale.ReadRow(Row));
+    EXPECT_FALSE(Stale.SeekRow(2));
+    EXPECT_TRUE(Stale.ReadRow(Row));
+    EXPECT_EQ(Row[0], "1");
+    EXPECT_EQ(Stale.Row(), 2);
+}
+
+TEST(DSVIndexedReader, FileRangeTest){
+    std::string Path = CreateTempFile(Rows(1000));
+    std::string IndexPath = Path + ".idx";
+    {
+        CDSVIndex Index(64);
+        Index.Build(std::make_shared<CFileDataSource>(Path), ',');
+        auto Sink = std::make_shared<CStringDataSink>();
+        EXPECT_TRUE(Index.Save(Sink));
+        WriteFile(IndexPath, Sink->String());
+    }
+    auto Index = std::make_shared<CDSVIndex>();
+    ASSERT_TRUE(Index->Load(std::make_shared<CFileDataSource>(IndexPath)));
+    CDSVIndexedReader Reader(std::make_shared<CFileDataSource>(Path), ',', Index);
+    std::vector<std::string_view> Row;
+
+    EXPECT_TRUE(Reader.SeekRow(500));
+    for(std::size_t Expected = 500; Expected < 600; Expected++){
+        EXPECT_TRUE(Reader.ReadRowView(Row));
+        EXPECT_EQ(Row[0], std::to_string(Expected));
+    }
+    std::remove(Path.c_str());
+    std::remove(IndexPath.c_str());
+}
+
+TEST(DSVIndexedReader, UnseekableTest){
+    class CNoSeekDataSource : public CStringDataSource{
+        public:
+            CNoSeekDataSource(const std::string &str) : CStringDataSource(str){}
+            bool Seek(std::size_t offset) noexcept override{ return false; }
+    };
+    auto Index = std::make_shared<CDSVIndex>(2);
+    Index->Build(std::make_shared<CStringDataSource>(Rows(5)), ',');
+    CDSVIndexedReader Reader(std::make_shared<CNoSeekDataSource>(Rows(5)), ',', Index);
+
+    EXPECT_FALSE(Reader.SeekRow(3));
+    EXPECT_EQ(Reader.Row(), 0);
+}
@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include "DSVParallelReader.h"
+#include "DSVReader.h"
+#include "FileDataSource.h"
+#include "StringDataSource.h"
+#include "TestFiles.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+static std::vector< std::vector<std::string> > ReadAll(CDSVReader &reader){
+    std::vector< std::vector<std::string> > Rows;
+    std::vector<std::string> Row;
+    while(reader.ReadRow(Row)){
+        Rows.push_back(Row);
+    }
+    return Rows;
+}
+
+static std::vector< std::vector<std::string> > ReadAll(CDSVParallelReader &reader){
+    std::vector< std::vector<std::string> > Rows;
+    std::vector<std::string> Row;
+    while(!reader.End()){
+        EXPECT_TRUE(reader.ReadRow(Row));
+        Rows.push_back(Row);
+    }
+    EXPECT_FALSE(reader.ReadRow(Row));
+    return Rows;
+}
+
+static std::vector< std::vector<std::string> > Sequential(const std::string &input){
+    CDSVReader Reader(std::make_shared<CStringDataSource>(input), ',');
+    return ReadAll(Reader);
+}
+
+TEST(DSVParallelReader, EmptyTest){
+    CDSVParallelReader Reader(std::string_view(""), ',');
+    std::vector<std::string> Row;
+
+    EXPECT_TRUE(Reader.End());
+    EXPECT_FALSE(Reader.ReadRow(Row));
+}
+
+TEST(DSVParallelReader, OrderedTest){
+    std::string Input;
+    for(int Index = 0; Index < 1000; Index++){
+        Input += std::to_string(Index) + ",\"x\"\"" + std::to_string(Index) + "\",\"a\nb\"\n";
+    }
+    CDSVParallelReader Reader(std::string_view(Input), ',', true, 3, 64);
+    auto Rows = ReadAll(Reader);
+
+    ASSERT_EQ(Rows.size(), 1000);
+    EXPECT_EQ(Rows[7], std::vector<std::string>({"7", "x\"7", "a\nb"}));
+    EXPECT_EQ(Rows, Sequential(Input));
+}
+
+TEST(DSVParallelReader, UnorderedTest){
+    std::string Input;
+    for(int Index = 0; Index < 1000; Index++){
+        Input += std::to_string(Index) + ",b\n";
+    }
+    CDSVParallelReader Reader(std::make_shared<CStringDataSource>(Input), ',', false, 4, 32);
+    auto Rows = ReadAll(Reader);
+    auto Expected = Sequential(Input);
+
+    std::sort(Rows.begin(), Rows.end());
+    std::sort(Expected.begin(), Expected.end());
+    EXPECT_EQ(Rows, Expected);
+}
+
+TEST(DSVParallelReader, QuotedSplitTest){
+    // Quoted fields full of newlines straddle most chunk boundaries
+    std::string Field = "\"" + std::string(50, '\n') + "\"\"" + std::string(50, '\n') + "\"";
+    std::string Input = "a," + Field + "\n" + Field + ",b\n\"\"\"\n\",c\"d\n\n" + Field;
+    for(std::size_t ChunkSize = 1; ChunkSize < 40; ChunkSize++){
+        CDSVParallelReader Reader(std::string_view(Input), ',', true, 2, ChunkSize);
+        EXPECT_EQ(ReadAll(Reader), Sequential(Input));
+    }
+}
+
+TEST(DSVParallelReader, RandomTest){
+    const char Alphabet[] = {'a', ',', '"', '\n'};
+    std::mt19937 Generator(42);
+    for(int Iteration = 0; Iteration < 300; Iteration++){
+        std::string Input;
+        std::size_t Length = Generator() % 200;
+        for(std::size_t Index = 0; Index < Length; Index++){
+            Input += Alphabet[Generator() % 4];
+        }
+        CDSVParallelReader Reader(std::string_view(Input), ',', true, 1 + Generator() % 3, 1 + Generator() % 20);
+        EXPECT_EQ(ReadAll(Reader), Sequential(Input)) << Input;
+    }
+}
+
+TEST(DSVParallelReader, WindowTest){
+    // Sources that are not mapped are read a few chunks at a time, so rows
+    // and quoted fields also straddle the windows
+    std::string Field = "\"" + std::string(50, '\n') + "\"\"" + std::string(50, '\n') + "\"";
+    std::string Input = "a," + Field + "\n" + Field + ",b\n\"\"\"\n\",c\"d\n\n" + Field;
+    for(std::size_t ChunkSize = 1; ChunkSize < 40; ChunkSize++){
+        CDSVParallelReader Reader(std::make_shared<CStringDataSource>(Input), ',', true, 1 + ChunkSize % 3, ChunkSize);
+        EXPECT_EQ(ReadAll(Reader), Sequential(Input));
+    }
+
+    const char Alphabet[] = {'a', ',', '"', '\n'};
+    std::mt19937 Generator(7);
+    for(int Iteration = 0; Iteration < 300; Iteration++){
+        std::string Random;
+        std::size_t Length = Generator() % 200;
+        for(std::size_t Index = 0; Index < Length; Index++){
+            Random += Alphabet[Generator() % 4];
+        }
+        bool Ordered = Iteration % 2;
+        CDSVParallelReader Reader(std::make_shared<CStringDataSource>(Random), ',', Ordered, 1 + Generator() % 3, 1 + Generator() % 20);
+        auto Rows = ReadAll(Reader);
+        auto Expected = Sequential(Random);
+        if(!Ordered){
+            std::sort(Rows.begin(), Rows.end());
+            std::sort(Expected.begin(), Expected.end());
+        }
+        EXPECT_EQ(Rows, Expected) << Random;
+    }
+}
+
+TEST(DSVParallelReader, ViewTest){
+    std::string Input = "a,\"b\"\"c\"\nd,e";
+    CDSVParallelReader Reader(std::string_view(Input), ',', true, 2, 4);
+    std::vector<std::string_view> Row;
+
+    EXPECT_TRUE(Reader.ReadRowView(Row));
+    ASSERT_EQ(Row.size(), 2);
+    EXPECT_EQ(Row[0], "a");
+    EXPECT_EQ(Row[1], "b\"c");
+    EXPECT_TRUE(Reader.ReadRowView(Row));
+    ASSERT_EQ(Row.size(), 2);
+    EXPECT_EQ(Row[0], "d");
+    EXPECT_EQ(Row[1], "e");
+    EXPECT_TRUE(Reader.End());
+    EXPECT_FALSE(Reader.ReadRowView(Row));
+}
+
+TEST(DSVParallelReader, FileTest){
+    std::string Input;
+    for(int Index = 0; Index < 500; Index++){
+        Input += "\"" + std::to_string(Index) + "\n\"," + std::to_string(Index * 2) + "\n";
+    }
+    std::string Path = CreateTempFile(Input);
+    auto Source = std::make_shared<CFileDataSource>(Path);
+    ASSERT_TRUE(Source->IsMapped());
+    CDSVParallelReader Reader(Source, ',', true, 2, 100);
+
+    EXPECT_EQ(ReadAll(Reader), Sequential(Input));
+    std::remove(Path.c_str());
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include "DSVParallelWriter.h"
+#include "DSVWriter.h"
+#include "StringDataSink.h"
+#include <random>
+
+// Accepts a fixed number of bytes, then fails every write
+class CLimitedDataSink : public CDataSink{
+    private:
+        std::size_t DRemaining;
+    public:
+        std::string DString;
+
+        CLimitedDataSink(std::size_t limit) : DRemaining(limit){
+        }
+
+        bool Put(const char &ch) noexcept override{
+            return Write(&ch, 1);
+        }
+
+        bool Write(const std::vector<char> &buf) noexcept override{
+            return Write(buf.data(), buf.size());
+        }
+
+        bool Write(const char *data, std::size_t length) noexcept override{
+            if(length > DRemaining){
+                return false;
+            }
+            DRemaining -= length;
+            DString.append(data, length);
+            return true;
+        }
+};
+
+static std::vector< std::vector<std::string> > RandomRows(std::size_t count, std::mt19937 &rng){
+    static const char *Pieces[] = {"a", "bc", ",", "\"", "\n", " x ", "12345", ""};
+    std::vector< std::vector<std::string> > Rows(count);
+    for(auto &Row : Rows){
+        Row.resize(rng() % 6);
+        for(auto &Field : Row){
+            for(std::size_t Index = rng() % 4; Index; Index--){
+                Field += Pieces[rng() % 8];
+            }
+        }
+    }
+    return Rows;
+}
+
+TEST(DSVParallelWriter, EmptyTest){
+    auto Sink = std::make_shared<CStringDataSink>();
+    CDSVParallelWriter Writer(Sink, ',');
+
+    EXPECT_TRUE(Writer.WriteRows({}));
+    EXPECT_TRUE(Writer.Flush());
+    EXPECT_EQ(Sink->String(), "");
+}
+
+TEST(DSVParallelWriter, MatchesWriterTest){
+    std::mt19937 Rng(19);
+    for(std::size_t Threads : {1, 2, 5}){
+        for(bool QuoteAll : {false, true}){
+            auto Expected = std::make_shared<CStringDataSink>();
+            auto Sink = std::make_shared<CStringDataSink>();
+            CDSVWriter Writer(Expected, '\t', QuoteAll);
+            {
+                CDSVParallelWriter ParallelWriter(Sink, '\t', QuoteAll, Threads);
+                for(int Batch = 0; Batch < 50; Batch++){
+                    auto Rows = RandomRows(Rng() % 200, Rng);
+                    EXPECT_TRUE(Writer.WriteRows(Rows));
+                    EXPECT_TRUE(ParallelWriter.WriteRows(std::move(Rows)));
+                }
+            }
+            EXPECT_EQ(Sink->String(), Expected->String());
+        }
+    }
+}
+
+TEST(DSVParallelWriter, FlushTest){
+    auto Sink = std::make_shared<CStringDataSink>();
+    CDSVParallelWriter Writer(Sink, ',', false, 3);
+
+    EXPECT_TRUE(Writer.WriteRows({{"a", "b,c"}, {"d"}}));
+    EXPECT_TRUE(Writer.WriteRows({{"e\"f"}}));
+    EXPECT_TRUE(Writer.Flush());
+    EXPECT_EQ(Sink->String(), "a,\"b,c\"\nd\n\"e\"\"f\"\n");
+    EXPECT_TRUE(Writer.WriteRows({{"g"}}));
+    EXPECT_TRUE(Writer.Flush());
+    EXPECT_EQ(Sink->String(), "a,\"b,c\"\nd\n\"e\"\"f\"\ng\n");
+}
+
+TEST(DSVParallelWriter, SinkFailureTest){
+    auto Sink = std::make_shared<CLimitedDataSink>(10);
+    CDSVParallelWriter Writer(Sink, ',', false, 2);
+
+    // The failure may already be seen by later calls, only the first must succeed
+    EXPECT_TRUE(Writer.WriteRows({{"first"}}));
+    Writer.WriteRows({{"second", "row"}});
+    Writer.WriteRows({{"x"}});
+    EXPECT_FALSE(Writer.Flush());
+    EXPECT_FALSE(Writer.WriteRows({{"y"}}));
+    // Batches after the failed one are dropped rather than written out of place
+    EXPECT_EQ(Sink->DString, "first\n");
+}
@@ -3,6 +3,7 @@
 #include "DSVWriter.h"
 #include "StringDataSource.h"
 #include "StringDataSink.h"
+#include "DSVScan.h"
 
 TEST(DSVReader, EmptyTest) {
     auto Source = std::make_shared<CStringDataSource>("");
@@ -132,3 +133,316 @@ TEST(DSVReader, QuoteEscapeTest) {
     EXPECT_EQ(Row[0], "My name is \"Bob\"!");
     EXPECT_EQ(Row[1], "3.3");
 }
+
+// Source that only implements the per-character interface so the readers
+// exercise the default single byte PeekBlock/Consume fallback
+class CCharOnlyDataSource : public CDataSource{
+    private:
+        CStringDataSource DSource;
+    public:
+        CCharOnlyDataSource(const std::string &str) : DSource(str){}
+        bool End() const noexcept override{ return DSource.End(); }
+        bool Get(char &ch) noexcept override{ return DSource.Get(ch); }
+        bool Peek(char &ch) noexcept override{ return DSource.Peek(ch); }
+        bool Read(std::vector<char> &buf, std::size_t count) noexcept override{ return DSource.Read(buf, count); }
+};
+
+TEST(DSVReader, CharOnlySourceTest) {
+    auto Source = std::make_shared<CCharOnlyDataSource>("\"a\"\"b\",c\nd,\"e\nf\"\n");
+    CDSVReader Reader(Source, ',');
+    std::vector<std::string> Row;
+    
+    EXPECT_TRUE(Reader.ReadRow(Row));
+    ASSERT_EQ(Row.size(), 2);
+    EXPECT_EQ(Row[0], "a\"b");
+    EXPECT_EQ(Row[1], "c");
+    EXPECT_TRUE(Reader.ReadRow(Row));
+    ASSERT_EQ(Row.size(), 2);
+    EXPECT_EQ(Row[0], "d");
+    EXPECT_EQ(Row[1], "e\nf");
+    EXPECT_TRUE(Reader.End());
+    EXPECT_FALSE(Reader.ReadRow(Row));
+}
+
+TEST(DSVScan, FindStructuralTest) {
+    const char Structurals[] = {',', '"', '\n'};
+    for(size_t Length = 0; Length < 100; Length++){
+        std::string Buffer(Length, 'x');
+        EXPECT_EQ(DSVScan::FindStructural(Buffer.data(), Buffer.data() + Length, ','), Buffer.data() + Length);
+        for(size_t Position = 0; Position < Length; Position++){
+            for(char Structural : Structurals){
+                Buffer[Position] = Structural;
+                EXPECT_EQ(DSVScan::FindStructural(Buffer.data(), Buffer.data() + Length, ','), Buffer.data() + Position);
+                Buffer[Position] = 'x';
+            }
+        }
+    }
+    std::string Buffer = "abc\tdef";
+    EXPECT_EQ(DSVScan::FindStructural(Buffer.data(), Buffer.data() + Buffer.size(), '\t'), Buffer.data() + 3);
+    EXPECT_EQ(DSVScan::FindStructural(Buffer.data(), Buffer.data() + Buffer.size(), ','), Buffer.data() + Buffer.size());
+}
+
+TEST(DSVReader, WideFieldTest) {
+    std::string Long(70, 'a');
+    auto Source = std::make_shared<CStringDataSource>(Long + "," + Long + "\"\"b," + "\"" + Long + "\"\"" + Long + "\"\n" + Long);
+    CDSVReader Reader(Source, ',');
+    std::vector<std::string> Row;
+    
+    EXPECT_TRUE(Reader.ReadRow(Row));
+    ASSERT_EQ(Row.size(), 3);
+    EXPECT_EQ(Row[0], Long);
+    EXPECT_EQ(Row[1], Long + "\"\"b");
+    EXPECT_EQ(Row[2], Long + "\"" + Long);
+    EXPECT_TRUE(Reader.ReadRow(Row));
+    ASSERT_EQ(Row.size(), 1);
+    EXPECT_EQ(Row[0], Long);
+    EXPECT_TRUE(Reader.End());
+}
+
+TEST(DSVReader, ReadRowViewTest) {
+    std::string Input = "a,\"b,c\",\"d\"\"e\"\n,\"\"\nlast";
+    auto Source = std::make_shared<CStringDataSource>(std::string_view(Input));
+    CDSVReader Reader(Source, ',');
+    std::vector<std::string_view> Row;
+    
+    EXPECT_TRUE(Reader.ReadRowView(Row));
+    ASSERT_EQ(Row.size(), 3);
+    EXPECT_EQ(Row[0], "a");
+    EXPECT_EQ(Row[1], "b,c");
+    EXPECT_EQ(Row[2], "d\"e");
+    EXPECT_EQ(Row[0].data(), Input.data());
+    EXPECT_EQ(Row[1].data(), Input.data() + 3);
+    EXPECT_TRUE(Reader.ReadRowView(Row));
+    ASSERT_EQ(Row.size(), 2);
+    EXPECT_EQ(Row[0], "");
+    EXPECT_EQ(Row[1], "");
+    EXPECT_TRUE(Reader.ReadRowView(Row));
+    ASSERT_EQ(Row.size(), 1);
+    EXPECT_EQ(Row[0], "last");
+    EXPECT_TRUE(Reader.End());
+    EXPECT_FALSE(Reader.ReadRowView(Row));
+}
+
+TEST(DSVReader, ReadRowViewSplitTest) {
+    auto Source = std::make_shared<CCharOnlyDataSource>("ab,\"c\"\"d\",\"e\nf\"\ng,h\n");
+    CDSVReader Reader(Source, ',');
+    std::vector<std::string_view> Row;
+    
+    EXPECT_TRUE(Reader.ReadRowView(Row));
+    ASSERT_EQ(Row.size(), 3);
+    EXPECT_EQ(Row[0], "ab");
+    EXPECT_EQ(Row[1], "c\"d");
+    EXPECT_EQ(Row[2], "e\nf");
+    EXPECT_TRUE(Reader.ReadRowView(Row));
+    ASSERT_EQ(Row.size(), 2);
+    EXPECT_EQ(Row[0], "g");
+    EXPECT_EQ(Row[1], "h");
+    EXPECT_TRUE(Reader.End());
+}
+
+TEST(DSVReader, ProjectionTest) {
+    auto Source = std::make_shared<CStringDataSource>("a,\"b\"\"\",c,d\ne,f\n");
+    CDSVReader Reader(Source, ',', std::vector<size_t>{3, 1, 1});
+    std::vector<std::string> Row;
+    
+    EXPECT_TRUE(Reader.ReadRow(Row));
+    ASSERT_EQ(Row.size(), 3);
+    EXPECT_EQ(Row[0], "d");
+    EXPECT_EQ(Row[1], "b\"");
+    EXPECT_EQ(Row[2], "b\"");
+    EXPECT_TRUE(Reader.ReadRow(Row));
+    ASSERT_EQ(Row.size(), 3);
+    EXPECT_EQ(Row[0], "");
+    EXPECT_EQ(Row[1], "f");
+    EXPECT_EQ(Row[2], "f");
+    EXPECT_FALSE(Reader.ReadRow(Row));
+}
+
+TEST(DSVReader, HeaderProjectionTest) {
+    auto Source = std::make_shared<CStringDataSource>("id,\"name\",age\n1,Bob,30\n2,\"Al, Jr\",40\n");
+    CDSVReader Reader(Source, ',', std::vector<std::string>{"age", "id", "missing"});
+    std::vector<std::string_view> Row;
+    
+    EXPECT_TRUE(Reader.ReadRowView(Row));
+    ASSERT_EQ(Row.size(), 3);
+    EXPECT_EQ(Row[0], "30");
+    EXPECT_EQ(Row[1], "1");
+    EXPECT_EQ(Row[2], "");
+    EXPECT_TRUE(Reader.ReadRowView(Row));
+    ASSERT_EQ(Row.size(), 3);
+    EXPECT_EQ(Row[0], "40");
+    EXPECT_EQ(Row[1], "2");
+    EXPECT_TRUE(Reader.End());
+}
+
+TEST(DSVWriter, WriteRowsTest) {
+    std::vector<std::vector<std::string>> Rows = {{"a", "b,c", "say \"hi\""}, {}, {"", "x\ny"}, {"\"\"", "plain"}};
+    for(bool QuoteAll : {false, true}){
+        auto RowSink = std::make_shared<CStringDataSink>();
+        auto BatchSink = std::make_shared<CStringDataSink>();
+        CDSVWriter RowWriter(RowSink, ',', QuoteAll);
+        CDSVWriter BatchWriter(BatchSink, ',', QuoteAll);
+        
+        for(auto &Row : Rows){
+            EXPECT_TRUE(RowWriter.WriteRow(Row));
+        }
+        EXPECT_TRUE(BatchWriter.WriteRows(Rows));
+        EXPECT_EQ(BatchSink->String(), RowSink->String());
+    }
+}
+
+TEST(DSVWriter, WriteRowsLargeTest) {
+    // Enough output to be handed to the sink in several blocks
+    std::vector<std::vector<std::string>> Rows(50000, {std::string(20, 'x'), "a\"b", "1,2"});
+    auto Sink = std::make_shared<CStringDataSink>();
+    CDSVWriter Writer(Sink, ',');
+    std::string Expected;
+    for(size_t Index = 0; Index < Rows.size(); Index++){
+        Expected += std::string(20, 'x') + ",\"a\"\"b\",\"1,2\"\n";
+    }
+    
+    EXPECT_TRUE(Writer.WriteRows(Rows));
+    EXPECT_EQ(Sink->String(), Expected);
+    EXPECT_TRUE(Writer.WriteRows({}));
+    EXPECT_EQ(Sink->String().size(), Expected.size());
+}
+
+TEST(DSVReader, ReadRowsTest) {
+    auto Source = std::make_shared<CStringDataSource>("a,\"b\"\"c\"\n\nd,e,f\n\"g\nh\"");
+    CDSVReader Reader(Source, ',');
+    CDSVRowBatch Batch;
+    std::vector<std::string_view> Row;
+    
+    EXPECT_TRUE(Reader.ReadRows(Batch, 3));
+    ASSERT_EQ(Batch.RowCount(), 3);
+    EXPECT_EQ(Batch.FieldCount(0), 2);
+    EXPECT_EQ(Batch.Field(0, 1), "b\"c");
+    EXPECT_EQ(Batch.FieldCount(1), 1);
+    EXPECT_EQ(Batch.Field(1, 0), "");
+    Batch.Row(2, Row);
+    ASSERT_EQ(Row.size(), 3);
+    EXPECT_EQ(Row[0], "d");
+    EXPECT_EQ(Row[2], "f");
+    EXPECT_TRUE(Reader.ReadRows(Batch, 3));
+    ASSERT_EQ(Batch.RowCount(), 1);
+    EXPECT_EQ(Batch.Field(0, 0), "g\nh");
+    EXPECT_FALSE(Reader.ReadRows(Batch, 3));
+    EXPECT_EQ(Batch.RowCount(), 0);
+}
+
+TEST(DSVReader, ReadRowsReuseTest) {
+    std::string Input;
+    for(int Index = 0; Index < 100; Index++){
+        Input += std::to_string(Index) + ",x\n";
+    }
+    CDSVReader Reader(std::make_shared<CStringDataSource>(Input), ',', std::vector<size_t>{1, 0});
+    CDSVRowBatch Batch;
+    int Expected = 0;
+    
+    while(Reader.ReadRows(Batch, 30)){
+        for(size_t Row = 0; Row < Batch.RowCount(); Row++, Expected++){
+            ASSERT_EQ(Batch.FieldCount(Row), 2);
+            EXPECT_EQ(Batch.Field(Row, 0), "x");
+            EXPECT_EQ(Batch.Field(Row, 1), std::to_string(Expected));
+        }
+    }
+    EXPECT_EQ(Expected, 100);
+}
+
+TEST(DSVScan, FindSubstringTest) {
+    std::string Needles[] = {"a", "ab", "abc", "aXa", std::string(40, 'a') + "b"};
+    for(auto &Needle : Needles){
+        for(size_t Length = 0; Length < 120; Length++){
+            // Near misses everywhere, the needle itself at one position
+            std::string Buffer;
+            for(size_t Index = 0; Index < Length; Index++){
+                Buffer += Index % 7 ? 'a' : 'X';
+            }
+            EXPECT_EQ(DSVScan::FindSubstring(Buffer.data(), Buffer.data() + Length, Needle.data(), Needle.size()), Buffer.data() + std::min(Buffer.find(Needle), Length));
+            for(size_t Position = 0; Position + Needle.size() <= Length; Position += 5){
+                std::string Placed = Buffer;
+                Placed.replace(Position, Needle.size(), Needle);
+                EXPECT_EQ(DSVScan::FindSubstring(Placed.data(), Placed.data() + Length, Needle.data(), Needle.size()), Placed.data() + Placed.find(Needle));
+            }
+        }
+    }
+    std::string Buffer = "abc";
+    EXPECT_EQ(DSVScan::FindSubstring(Buffer.data(), Buffer.data() + 3, "", 0), Buffer.data());
+    EXPECT_EQ(DSVScan::FindSubstring(Buffer.data(), Buffer.data() + 3, "abcd", 4), Buffer.data() + 3);
+}
+
+TEST(DSVScan, FindRowStartTest) {
+    std::string Buffer = "a,b\n\"c\nd\",e\nf\n\"g\"\"\n\",h\ni";
+    const char *Begin = Buffer.data();
+    EXPECT_EQ(DSVScan::FindRowStart(Begin, Begin + 2, ','), Begin);
+    EXPECT_EQ(DSVScan::FindRowStart(Begin, Begin + 4, ','), Begin + 4);
+    // Inside a quoted newline the row still starts at its first field
+    EXPECT_EQ(DSVScan::FindRowStart(Begin, Begin + 8, ','), Begin + 4);
+    EXPECT_EQ(DSVScan::FindRowStart(Begin, Begin + 13, ','), Begin + 12);
+    EXPECT_EQ(DSVScan::FindRowStart(Begin, Begin + 19, ','), Begin + 14);
+    EXPECT_EQ(DSVScan::FindRowStart(Begin, Begin + Buffer.size(), ','), Begin + Buffer.size() - 1);
+}
+
+TEST(DSVReader, FilterContainsTest) {
+    std::string Input = "1,cust42\n"
+                        "2,cust4,2\n"                 // Raw match across two fields
+                        "3,\"note\ncust42,fake\"\n"   // Match inside a quoted newline
+                        "4,other\n"
+                        "5,\"cust\"\"42\"\n"
+                        "6,x\"cust42\"\n"
+                        "7,cust42";
+    for(bool Split : {false, true}){
+        std::shared_ptr<CDataSource> Source;
+        if(Split){
+            Source = std::make_shared<CCharOnlyDataSource>(Input);
+        }
+        else{
+            Source = std::make_shared<CStringDataSource>(Input);
+        }
+        CDSVReader Reader(Source, ',');
+        Reader.FilterContains("cust42");
+        std::vector<std::string> Row;
+        
+        EXPECT_TRUE(Reader.ReadRow(Row));
+        EXPECT_EQ(Row, std::vector<std::string>({"1", "cust42"}));
+        EXPECT_TRUE(Reader.ReadRow(Row));
+        EXPECT_EQ(Row, std::vector<std::string>({"3", "note\ncust42,fake"}));
+        EXPECT_TRUE(Reader.ReadRow(Row));
+        EXPECT_EQ(Row, std::vector<std::string>({"6", "x\"cust42\""}));
+        EXPECT_TRUE(Reader.ReadRow(Row));
+        EXPECT_EQ(Row, std::vector<std::string>({"7", "cust42"}));
+        EXPECT_FALSE(Reader.ReadRow(Row));
+        EXPECT_TRUE(Reader.End());
+    }
+    
+    // Text with a quote is checked on the unescaped fields of every row
+    CDSVReader Reader(std::make_shared<CStringDataSource>(Input), ',');
+    Reader.FilterContains("t\"4");
+    std::vector<std::string_view> Row;
+    EXPECT_TRUE(Reader.ReadRowView(Row));
+    ASSERT_EQ(Row.size(), 2);
+    EXPECT_EQ(Row[0], "5");
+    EXPECT_EQ(Row[1], "cust\"42");
+    EXPECT_FALSE(Reader.ReadRowView(Row));
+}
+
+TEST(DSVReader, FilterEqualsTest) {
+    std::string Input = "id,name,city\n1,Bob,Davis\n2,Davis,Sacramento\n3,\"Al\",\"Davis\"\n4,Cy\n5,Di,Davis2\n";
+    CDSVReader Reader(std::make_shared<CStringDataSource>(Input), ',', std::vector<size_t>{1});
+    Reader.FilterEquals(2, "Davis");
+    CDSVRowBatch Batch;
+    
+    EXPECT_TRUE(Reader.ReadRows(Batch, 10));
+    ASSERT_EQ(Batch.RowCount(), 2);
+    EXPECT_EQ(Batch.FieldCount(0), 1);
+    EXPECT_EQ(Batch.Field(0, 0), "Bob");
+    EXPECT_EQ(Batch.Field(1, 0), "Al");
+    
+    // A missing field reads as empty
+    CDSVReader EmptyReader(std::make_shared<CStringDataSource>(Input), ',');
+    EmptyReader.FilterEquals(2, "");
+    std::vector<std::string> Row;
+    EXPECT_TRUE(EmptyReader.ReadRow(Row));
+    EXPECT_EQ(Row, std::vector<std::string>({"4", "Cy"}));
+    EXPECT_FALSE(EmptyReader.ReadRow(Row));
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include "FileDataSink.h"
+#include "TestFiles.h"
+#include <cstdio>
+
+TEST(FileDataSink, BadPathTest){
+    CFileDataSink Sink("/tmp/this/file/does/not/exist");
+
+    EXPECT_FALSE(Sink.IsOpen());
+    EXPECT_FALSE(Sink.Put('x'));
+    EXPECT_FALSE(Sink.Flush());
+}
+
+TEST(FileDataSink, PutTest){
+    std::string Name = TempFileName();
+    {
+        CFileDataSink Sink(Name);
+
+        EXPECT_TRUE(Sink.IsOpen());
+        EXPECT_TRUE(Sink.Put('H'));
+        EXPECT_TRUE(Sink.Put('i'));
+        EXPECT_EQ(FileContents(Name),"");
+        EXPECT_TRUE(Sink.Flush());
+        EXPECT_EQ(FileContents(Name),"Hi");
+        EXPECT_TRUE(Sink.Put('!'));
+    }
+    EXPECT_EQ(FileContents(Name),"Hi!");
+    std::remove(Name.c_str());
+}
+
+TEST(FileDataSink, WriteTest){
+    std::string Name = TempFileName();
+    std::vector<char> Small = {'a','b','c'};
+    std::vector<char> Large(10000,'z');
+    // Buffer rounds up to a single 4 KB block so both large-write paths run
+    CFileDataSink Sink(Name, true, 100);
+
+    EXPECT_TRUE(Sink.Write(Small));
+    EXPECT_TRUE(Sink.Write(Large));
+    for(int Index = 0; Index < 2000; Index++){
+        EXPECT_TRUE(Sink.Write(Small));
+    }
+    EXPECT_TRUE(Sink.Close());
+    EXPECT_FALSE(Sink.IsOpen());
+
+    std::string Expected = "abc" + std::string(10000,'z');
+    for(int Index = 0; Index < 2000; Index++){
+        Expected += "abc";
+    }
+    EXPECT_EQ(FileContents(Name),Expected);
+    std::remove(Name.c_str());
+}
+
+TEST(FileDataSink, BulkWriteTest){
+    std::string Name = TempFileName();
+    std::string Large(5000,'y');
+    std::string_view Segments[] = {"a", "", Large, "b"};
+    CFileDataSink Sink(Name, false, 4096);
+
+    EXPECT_TRUE(Sink.Write(std::string_view("Hi ")));
+    EXPECT_TRUE(Sink.WriteV(Segments, 2));
+    EXPECT_TRUE(Sink.WriteV(Segments, 4));
+    EXPECT_TRUE(Sink.Write("xyz", 2));
+    EXPECT_TRUE(Sink.Close());
+    EXPECT_EQ(FileContents(Name),"Hi aa" + Large + "bxy");
+    std::remove(Name.c_str());
+}
@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+#include "FileDataSource.h"
+#include "DSVReader.h"
+#include "XMLReader.h"
+#include "TestFiles.h"
+#include <cstdio>
+#include <unistd.h>
+
+TEST(FileDataSource, MissingFileTest){
+    CFileDataSource Source("/tmp/this/file/does/not/exist");
+    char TempCh = 'x';
+
+    EXPECT_FALSE(Source.IsOpen());
+    EXPECT_TRUE(Source.End());
+    EXPECT_FALSE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'x');
+}
+
+TEST(FileDataSource, EmptyFileTest){
+    std::string Name = CreateTempFile("");
+    CFileDataSource Source(Name);
+    const char *Data;
+    std::size_t Length;
+
+    EXPECT_TRUE(Source.IsOpen());
+    EXPECT_TRUE(Source.End());
+    EXPECT_FALSE(Source.PeekBlock(Data,Length));
+    std::remove(Name.c_str());
+}
+
+TEST(FileDataSource, ZeroSizeFileTest){
+    // Files under /proc report a size of 0 but have content
+    CFileDataSource Source("/proc/self/status");
+    std::vector<char> Contents;
+
+    ASSERT_TRUE(Source.IsOpen());
+    EXPECT_FALSE(Source.IsMapped());
+    EXPECT_FALSE(Source.End());
+    EXPECT_TRUE(Source.Read(Contents, 4096));
+    EXPECT_EQ(std::string(Contents.data(), 5), "Name:");
+}
+
+TEST(FileDataSource, MappedTest){
+    std::string Name = CreateTempFile("Hello World");
+    CFileDataSource Source(Name);
+    std::vector<char> TempVector;
+    const char *Data;
+    std::size_t Length;
+    char TempCh;
+
+    EXPECT_TRUE(Source.IsMapped());
+    EXPECT_TRUE(Source.Peek(TempCh));
+    EXPECT_EQ(TempCh,'H');
+    EXPECT_TRUE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'H');
+    EXPECT_TRUE(Source.Read(TempVector,4));
+    EXPECT_EQ(std::string(TempVector.begin(),TempVector.end()),"ello");
+    EXPECT_TRUE(Source.PeekBlock(Data,Length));
+    EXPECT_EQ(std::string(Data,Length)," World");
+    EXPECT_EQ(Source.Consume(100),6);
+    EXPECT_TRUE(Source.End());
+    std::remove(Name.c_str());
+}
+
+TEST(FileDataSource, PipeTest){
+    int Pipe[2];
+    ASSERT_EQ(pipe(Pipe),0);
+    std::string Contents = "a,b\nc,\"d\ne\"\n";
+    ASSERT_EQ(write(Pipe[1], Contents.data(), Contents.size()), (ssize_t)Contents.size());
+    close(Pipe[1]);
+    // A tiny buffer forces rows to straddle several read() calls
+    auto Source = std::make_shared<CFileDataSource>("/dev/fd/" + std::to_string(Pipe[0]), 3);
+    close(Pipe[0]);
+    CDSVReader Reader(Source, ',');
+    std::vector<std::string> Row;
+
+    EXPECT_FALSE(Source->IsMapped());
+    EXPECT_TRUE(Reader.ReadRow(Row));
+    ASSERT_EQ(Row.size(), 2);
+    EXPECT_EQ(Row[0], "a");
+    EXPECT_EQ(Row[1], "b");
+    EXPECT_TRUE(Reader.ReadRow(Row));
+    ASSERT_EQ(Row.size(), 2);
+    EXPECT_EQ(Row[0], "c");
+    EXPECT_EQ(Row[1], "d\ne");
+    EXPECT_TRUE(Reader.End());
+}
+
+TEST(FileDataSource, XMLTest){
+    std::string Name = CreateTempFile("<root><child attr=\"v\">text</child></root>");
+    CXMLReader Reader(std::make_shared<CFileDataSource>(Name));
+    SXMLEntity Entity;
+
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DNameData, "root");
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DNameData, "child");
+    EXPECT_EQ(Entity.AttributeValue("attr"), "v");
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DType, SXMLEntity::EType::CharData);
+    EXPECT_EQ(Entity.DNameData, "text");
+    std::remove(Name.c_str());
+}
+
+TEST(FileDataSource, SeekTest){
+    std::string Name = CreateTempFile("0123456789");
+    CFileDataSource Source(Name);
+    char TempCh;
+
+    ASSERT_TRUE(Source.IsMapped());
+    EXPECT_TRUE(Source.Seek(7));
+    EXPECT_TRUE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'7');
+    EXPECT_TRUE(Source.Seek(2));
+    EXPECT_TRUE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'2');
+    EXPECT_TRUE(Source.Seek(10));
+    EXPECT_TRUE(Source.End());
+    EXPECT_FALSE(Source.Seek(11));
+    std::remove(Name.c_str());
+}
+
+TEST(FileDataSource, PipeSeekTest){
+    int Pipe[2];
+    ASSERT_EQ(pipe(Pipe),0);
+    ASSERT_EQ(write(Pipe[1], "abc", 3), 3);
+    close(Pipe[1]);
+    CFileDataSource Source("/dev/fd/" + std::to_string(Pipe[0]), 2);
+    close(Pipe[0]);
+    char TempCh;
+
+    EXPECT_TRUE(Source.Get(TempCh));
+    EXPECT_FALSE(Source.Seek(0));
+    EXPECT_TRUE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'b');
+}
+
+TEST(FileDataSource, PipeEndKeepsViewTest){
+    int Pipe[2];
+    ASSERT_EQ(pipe(Pipe),0);
+    std::string Contents = "aaaa\nbbbb\ncccc\n";
+    ASSERT_EQ(write(Pipe[1], Contents.data(), Contents.size()), (ssize_t)Contents.size());
+    close(Pipe[1]);
+    auto Source = std::make_shared<CFileDataSource>("/dev/fd/" + std::to_string(Pipe[0]), 5);
+    close(Pipe[0]);
+    const char *Data;
+    std::size_t Length;
+
+    // End reads the next block ahead without touching the viewed one
+    ASSERT_TRUE(Source->PeekBlock(Data, Length));
+    ASSERT_EQ(Length, 5);
+    EXPECT_EQ(Source->Consume(5), 5);
+    EXPECT_FALSE(Source->End());
+    EXPECT_EQ(std::string(Data, 5), "aaaa\n");
+    ASSERT_TRUE(Source->PeekBlock(Data, Length));
+    EXPECT_EQ(std::string(Data, Length), "bbbb\n");
+
+    CDSVReader Reader(Source, ',');
+    std::vector<std::string_view> Row;
+    ASSERT_TRUE(Reader.ReadRowView(Row));
+    ASSERT_EQ(Row.size(), 1);
+    EXPECT_FALSE(Reader.End());
+    EXPECT_EQ(Row[0], "bbbb");
+    ASSERT_TRUE(Reader.ReadRowView(Row));
+    EXPECT_TRUE(Reader.End());
+    EXPECT_EQ(Row[0], "cccc");
+}
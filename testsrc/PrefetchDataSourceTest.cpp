@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include "PrefetchDataSource.h"
+#include "StringDataSource.h"
+#include "DSVReader.h"
+#include "XMLReader.h"
+#include <chrono>
+#include <thread>
+
+TEST(PrefetchDataSource, EmptyTest){
+    CPrefetchDataSource Source(std::make_shared<CStringDataSource>(""));
+    const char *Data;
+    std::size_t Length;
+    char TempCh = 'x';
+
+    EXPECT_TRUE(Source.End());
+    EXPECT_FALSE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'x');
+    EXPECT_FALSE(Source.PeekBlock(Data,Length));
+}
+
+TEST(PrefetchDataSource, BlockTest){
+    // Two byte blocks in a ring of two force the reader to wait on refills
+    CPrefetchDataSource Source(std::make_shared<CStringDataSource>("Hello World"), 2, 2);
+    std::vector<char> TempVector;
+    const char *Data;
+    std::size_t Length;
+    char TempCh;
+
+    EXPECT_FALSE(Source.End());
+    EXPECT_TRUE(Source.Peek(TempCh));
+    EXPECT_EQ(TempCh,'H');
+    EXPECT_TRUE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'H');
+    EXPECT_TRUE(Source.PeekBlock(Data,Length));
+    EXPECT_EQ(std::string(Data,Length),"e");
+    EXPECT_EQ(Source.Consume(3),3);
+    EXPECT_TRUE(Source.Read(TempVector,6));
+    EXPECT_EQ(std::string(TempVector.begin(),TempVector.end()),"o Worl");
+    EXPECT_TRUE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'d');
+    EXPECT_TRUE(Source.End());
+    EXPECT_EQ(Source.Consume(1),0);
+}
+
+TEST(PrefetchDataSource, DSVTest){
+    std::string Input;
+    for(int Index = 0; Index < 1000; Index++){
+        Input += std::to_string(Index) + ",\"quoted\nvalue " + std::to_string(Index) + "\"\n";
+    }
+    CDSVReader Reader(std::make_shared<CPrefetchDataSource>(std::make_shared<CStringDataSource>(Input), 7, 3), ',');
+    std::vector<std::string> Row;
+
+    for(int Index = 0; Index < 1000; Index++){
+        ASSERT_TRUE(Reader.ReadRow(Row));
+        ASSERT_EQ(Row.size(), 2);
+        EXPECT_EQ(Row[0], std::to_string(Index));
+        EXPECT_EQ(Row[1], "quoted\nvalue " + std::to_string(Index));
+    }
+    EXPECT_TRUE(Reader.End());
+}
+
+TEST(PrefetchDataSource, XMLTest){
+    CXMLReader Reader(std::make_shared<CPrefetchDataSource>(std::make_shared<CStringDataSource>("<root><child>text</child></root>"), 5));
+    SXMLEntity Entity;
+
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DNameData, "root");
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DNameData, "child");
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DNameData, "text");
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DType, SXMLEntity::EType::EndElement);
+    EXPECT_EQ(Entity.DNameData, "root");
+    EXPECT_FALSE(Reader.ReadEntity(Entity));
+}
+
+TEST(PrefetchDataSource, EndKeepsViewTest){
+    CPrefetchDataSource Source(std::make_shared<CStringDataSource>("aaaabbbbcccc"), 4, 2);
+    const char *Data;
+    std::size_t Length;
+
+    // End must not hand the viewed block back for the next refill
+    ASSERT_TRUE(Source.PeekBlock(Data,Length));
+    ASSERT_EQ(std::string(Data,Length),"aaaa");
+    EXPECT_EQ(Source.Consume(4),4);
+    EXPECT_FALSE(Source.End());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(std::string(Data,4),"aaaa");
+    ASSERT_TRUE(Source.PeekBlock(Data,Length));
+    EXPECT_EQ(std::string(Data,Length),"bbbb");
+    EXPECT_EQ(Source.Consume(4),4);
+    ASSERT_TRUE(Source.PeekBlock(Data,Length));
+    EXPECT_EQ(Source.Consume(4),4);
+    EXPECT_TRUE(Source.End());
+    EXPECT_EQ(std::string(Data,4),"cccc");
+
+    CDSVReader Reader(std::make_shared<CPrefetchDataSource>(std::make_shared<CStringDataSource>("aaaa\nbbbb\ncccc\n"), 5, 2), ',');
+    std::vector<std::string_view> Row;
+    ASSERT_TRUE(Reader.ReadRowView(Row));
+    EXPECT_FALSE(Reader.End());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(Row[0],"aaaa");
+}
+
+TEST(PrefetchDataSource, LargeXMLTest){
+    std::string Document = "<root>";
+    for(int Index = 0; Index < 40000; Index++){
+        Document += "<item id=\"" + std::to_string(Index) + "\">value &amp; " + std::to_string(Index) + "</item>\n";
+    }
+    Document += "</root>";
+    ASSERT_GT(Document.size(), 1024 * 1024);
+    // Blocks of 64 KB and more are handed to the reader whole
+    for(std::size_t BlockSize : {64 * 1024, 256 * 1024}){
+        CXMLReader Reader(std::make_shared<CPrefetchDataSource>(std::make_shared<CStringDataSource>(Document), BlockSize, 2));
+        CXMLReader Expected(std::make_shared<CStringDataSource>(Document));
+        SXMLEntity Entity, ExpectedEntity;
+        std::size_t Count = 0;
+        while(Expected.ReadEntity(ExpectedEntity)){
+            ASSERT_TRUE(Reader.ReadEntity(Entity));
+            ASSERT_EQ(Entity.DNameData, ExpectedEntity.DNameData);
+            ASSERT_EQ(Entity.DAttributes, ExpectedEntity.DAttributes);
+            Count++;
+        }
+        EXPECT_FALSE(Reader.ReadEntity(Entity));
+        EXPECT_TRUE(Reader.End());
+        EXPECT_EQ(Count, 120002);
+    }
+}
+
+TEST(PrefetchDataSource, LargeRowViewTest){
+    std::string Input;
+    for(int Index = 0; Index < 50000; Index++){
+        Input += std::to_string(Index) + ",value " + std::to_string(Index) + ",\"quoted\n" + std::to_string(Index) + "\"\n";
+    }
+    ASSERT_GT(Input.size(), 1024 * 1024);
+    CDSVReader Reader(std::make_shared<CPrefetchDataSource>(std::make_shared<CStringDataSource>(Input), 64 * 1024, 2), ',');
+    std::vector<std::string_view> Row;
+
+    // Fields must survive End, which looks past the block they point into
+    for(int Index = 0; Index < 50000; Index++){
+        ASSERT_TRUE(Reader.ReadRowView(Row));
+        Reader.End();
+        ASSERT_EQ(Row.size(), 3);
+        ASSERT_EQ(Row[0], std::to_string(Index));
+        ASSERT_EQ(Row[1], "value " + std::to_string(Index));
+        ASSERT_EQ(Row[2], "quoted\n" + std::to_string(Index));
+    }
+    EXPECT_TRUE(Reader.End());
+}
@@ -30,3 +30,15 @@ TEST(StringDataSink, WriteTest){
     EXPECT_TRUE(Sink.Write(TempVector2));
     EXPECT_EQ(Sink.String(),"Hello World");   
 }
+
+TEST(StringDataSink, BulkWriteTest){
+    CStringDataSink Sink;
+    std::string Hello = "Hello";
+    std::string_view Segments[] = {" ", "big", " ", "World"};
+
+    EXPECT_TRUE(Sink.Write(Hello));
+    EXPECT_TRUE(Sink.Write("!!!", 1));
+    EXPECT_TRUE(Sink.WriteV(Segments, 4));
+    EXPECT_TRUE(Sink.WriteV(Segments, 0));
+    EXPECT_EQ(Sink.String(),"Hello! big World");
+}
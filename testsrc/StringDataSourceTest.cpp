@@ -81,3 +81,63 @@ TEST(StringDataSource, ReadTest){
     EXPECT_FALSE(Source2.Peek(TempCh));
     EXPECT_EQ(TempCh,'x');
 }
+
+TEST(StringDataSource, BlockTest){
+    CStringDataSource EmptySource("");
+    CStringDataSource Source("Hello");
+    const char *Data = nullptr;
+    std::size_t Length = 0;
+    char TempCh = 'x';
+
+    EXPECT_FALSE(EmptySource.PeekBlock(Data,Length));
+    EXPECT_EQ(Length,0);
+    EXPECT_EQ(EmptySource.Consume(3),0);
+    EXPECT_TRUE(Source.PeekBlock(Data,Length));
+    ASSERT_EQ(Length,5);
+    EXPECT_EQ(std::string(Data,Length),"Hello");
+    EXPECT_EQ(Source.Consume(2),2);
+    EXPECT_TRUE(Source.Peek(TempCh));
+    EXPECT_EQ(TempCh,'l');
+    EXPECT_TRUE(Source.PeekBlock(Data,Length));
+    EXPECT_EQ(std::string(Data,Length),"llo");
+    EXPECT_EQ(Source.Consume(10),3);
+    EXPECT_TRUE(Source.End());
+    EXPECT_FALSE(Source.PeekBlock(Data,Length));
+}
+
+TEST(StringDataSource, OwnershipTest){
+    std::string Moved = "Moved string that is too long for small string storage";
+    const char *MovedData = Moved.data();
+    CStringDataSource MovedSource(std::move(Moved));
+    std::string Borrowed = "Borrowed";
+    std::string_view BorrowedView = Borrowed;
+    CStringDataSource BorrowedSource(BorrowedView);
+    const char *Data;
+    std::size_t Length;
+
+    EXPECT_TRUE(MovedSource.PeekBlock(Data,Length));
+    EXPECT_EQ(Data,MovedData);
+    EXPECT_EQ(std::string(Data,Length),"Moved string that is too long for small string storage");
+    EXPECT_TRUE(BorrowedSource.PeekBlock(Data,Length));
+    EXPECT_EQ(Data,Borrowed.data());
+    EXPECT_EQ(Length,Borrowed.size());
+    BorrowedSource.Consume(3);
+    EXPECT_TRUE(BorrowedSource.PeekBlock(Data,Length));
+    EXPECT_EQ(std::string(Data,Length),"rowed");
+}
+
+TEST(StringDataSource, SeekTest){
+    CStringDataSource Source("Hello World");
+    char TempCh;
+
+    EXPECT_TRUE(Source.Seek(6));
+    EXPECT_TRUE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'W');
+    EXPECT_TRUE(Source.Seek(0));
+    EXPECT_TRUE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'H');
+    EXPECT_TRUE(Source.Seek(11));
+    EXPECT_TRUE(Source.End());
+    EXPECT_FALSE(Source.Seek(12));
+    EXPECT_TRUE(Source.End());
+}
@@ -0,0 +1,40 @@
+#ifndef TESTFILES_H
+#define TESTFILES_H
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+// Temporary files for the tests that go through the file system
+
+// Creates an empty file with a unique name under /tmp and returns the name
+inline std::string TempFileName(){
+    char Name[] = "/tmp/testfileXXXXXX";
+    int FileDescriptor = mkstemp(Name);
+    if(FileDescriptor >= 0){
+        close(FileDescriptor);
+    }
+    return Name;
+}
+
+inline void WriteFile(const std::string &name, const std::string &contents){
+    std::ofstream Output(name, std::ios::binary | std::ios::trunc);
+    Output << contents;
+}
+
+inline std::string CreateTempFile(const std::string &contents){
+    std::string Name = TempFileName();
+    WriteFile(Name, contents);
+    return Name;
+}
+
+inline std::string FileContents(const std::string &name){
+    std::ifstream Input(name, std::ios::binary);
+    std::stringstream Contents;
+    Contents << Input.rdbuf();
+    return Contents.str();
+}
+
+#endif
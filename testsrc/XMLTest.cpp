@@ -113,6 +113,438 @@ TEST(XMLReader, QuoteTest) {
     EXPECT_EQ(Entity.DNameData, "element");
 }
 
+// Records visited entities as strings so they can be compared with ReadEntity
+class CRecordingVisitor : public CXMLVisitor{
+    public:
+        std::vector<std::string> DEvents;
+
+        void StartElement(std::string_view name, const std::vector< TAttribute > &attributes) override{
+            std::string Event = "<" + std::string(name);
+            for(auto &Attribute : attributes){
+                Event += " " + std::string(Attribute.first) + "=" + std::string(Attribute.second);
+            }
+            DEvents.push_back(Event);
+        }
+
+        void EndElement(std::string_view name) override{
+            DEvents.push_back("/" + std::string(name));
+        }
+
+        void CharData(std::string_view data) override{
+            DEvents.push_back("#" + std::string(data));
+        }
+};
+
+static std::vector<std::string> EntityEvents(CXMLReader &reader){
+    std::vector<std::string> Events;
+    SXMLEntity Entity;
+    while(reader.ReadEntity(Entity)){
+        if(Entity.DType == SXMLEntity::EType::StartElement){
+            std::string Event = "<" + Entity.DNameData;
+            for(auto &Attribute : Entity.DAttributes){
+                Event += " " + Attribute.first + "=" + Attribute.second;
+            }
+            Events.push_back(Event);
+        }
+        else if(Entity.DType == SXMLEntity::EType::EndElement){
+            Events.push_back("/" + Entity.DNameData);
+        }
+        else{
+            Events.push_back("#" + Entity.DNameData);
+        }
+    }
+    return Events;
+}
+
+// Serves a string through one small buffer that PeekBlock refills, the way
+// sources that read into a buffer do. End looks at the position only.
+class CRefillingDataSource : public CDataSource{
+    private:
+        std::string DData;
+        std::size_t DPosition = 0;
+        std::size_t DBlockBegin = 0;
+        std::size_t DBlockEnd = 0;
+        std::vector<char> DBuffer;
+
+    public:
+        CRefillingDataSource(const std::string &data, std::size_t blocksize) : DData(data), DBuffer(blocksize){
+        }
+
+        bool End() const noexcept override{
+            return DPosition >= DData.size();
+        }
+
+        bool Get(char &ch) noexcept override{
+            return Peek(ch) && Consume(1);
+        }
+
+        bool Peek(char &ch) noexcept override{
+            const char *Data;
+            std::size_t Length;
+            if(!PeekBlock(Data, Length)){
+                return false;
+            }
+            ch = *Data;
+            return true;
+        }
+
+        bool Read(std::vector<char> &buf, std::size_t count) noexcept override{
+            buf.clear();
+            char TempChar;
+            while(buf.size() < count && Get(TempChar)){
+                buf.push_back(TempChar);
+            }
+            return !buf.empty();
+        }
+
+        bool PeekBlock(const char *&data, std::size_t &length) noexcept override{
+            if(End()){
+                return false;
+            }
+            if(DPosition >= DBlockEnd){
+                DBlockBegin = DPosition;
+                DBlockEnd = std::min(DData.size(), DPosition + DBuffer.size());
+                std::copy(DData.begin() + DBlockBegin, DData.begin() + DBlockEnd, DBuffer.begin());
+            }
+            data = DBuffer.data() + (DPosition - DBlockBegin);
+            length = DBlockEnd - DPosition;
+            return true;
+        }
+
+        std::size_t Consume(std::size_t count) noexcept override{
+            count = std::min(count, DBlockEnd - DPosition);
+            DPosition += count;
+            return count;
+        }
+};
+
+TEST(XMLReader, VisitorTest) {
+    std::string Document = "<root a=\"1\" b=\"&lt;2&gt;\">\n  <child>text &amp; more</child>\n  <empty x=\"y\"/> tail<c/></root>";
+    CXMLReader EntityReader(std::make_shared<CStringDataSource>(Document));
+    CXMLReader Reader(std::make_shared<CStringDataSource>(Document));
+    CRecordingVisitor Visitor;
+    
+    EXPECT_TRUE(Reader.Parse(Visitor));
+    EXPECT_EQ(Visitor.DEvents, EntityEvents(EntityReader));
+    ASSERT_EQ(Visitor.DEvents.size(), 10);
+    EXPECT_EQ(Visitor.DEvents[0], "<root a=1 b=<2>");
+    // Whitespace before a tag is held back and joins the next text
+    EXPECT_EQ(Visitor.DEvents[2], "#\n  text & more");
+    EXPECT_EQ(Visitor.DEvents[6], "#\n   tail");
+    EXPECT_TRUE(Reader.End());
+}
+
+TEST(XMLReader, VisitorAfterReadEntityTest) {
+    std::string Document = "<root><a>1</a><b>2</b></root>";
+    CXMLReader Reader(std::make_shared<CStringDataSource>(Document));
+    CRecordingVisitor Visitor;
+    SXMLEntity Entity;
+    
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DNameData, "root");
+    EXPECT_TRUE(Reader.Parse(Visitor));
+    EXPECT_EQ(Visitor.DEvents, std::vector<std::string>({"<a", "#1", "/a", "<b", "#2", "/b", "/root"}));
+    EXPECT_FALSE(Reader.ReadEntity(Entity));
+}
+
+TEST(XMLReader, VisitorErrorTest) {
+    CXMLReader Reader(std::make_shared<CStringDataSource>("<root><a></b></root>"));
+    CRecordingVisitor Visitor;
+    
+    EXPECT_FALSE(Reader.Parse(Visitor));
+    EXPECT_EQ(Visitor.DEvents, std::vector<std::string>({"<root", "<a"}));
+    EXPECT_FALSE(Reader.Parse(Visitor));
+}
+
+TEST(XMLReader, RefillingSourceTest) {
+    std::string Document = "<root>";
+    for(int Index = 0; Index < 5000; Index++){
+        Document += "<item id=\"" + std::to_string(Index) + "\">value " + std::to_string(Index) + "</item>";
+    }
+    Document += "</root>";
+    CXMLReader Expected(std::make_shared<CStringDataSource>(Document));
+    std::vector<std::string> ExpectedEvents = EntityEvents(Expected);
+    
+    // Every chunk spans many refills of the source buffer
+    for(size_t BlockSize : {7, 4096, 100000}){
+        CXMLReader Reader(std::make_shared<CRefillingDataSource>(Document, BlockSize));
+        EXPECT_EQ(EntityEvents(Reader), ExpectedEvents);
+        EXPECT_TRUE(Reader.End());
+        CXMLReader VisitorReader(std::make_shared<CRefillingDataSource>(Document, BlockSize), 1000);
+        CRecordingVisitor Visitor;
+        EXPECT_TRUE(VisitorReader.Parse(Visitor));
+        EXPECT_EQ(Visitor.DEvents, ExpectedEvents);
+    }
+}
+
+TEST(XMLReader, ChunkSizeTest) {
+    std::string Document = "<root a=\"1\">";
+    for(int Index = 0; Index < 50; Index++){
+        Document += "<item id=\"" + std::to_string(Index) + "\">value &amp; " + std::to_string(Index) + "</item>";
+    }
+    Document += "</root>";
+    CXMLReader Expected(std::make_shared<CStringDataSource>(Document));
+    std::vector<std::string> ExpectedEvents = EntityEvents(Expected);
+    
+    // Tokens split across chunks must give the same entities
+    for(size_t ChunkSize : {1, 3, 64, 1024 * 1024}){
+        CXMLReader Reader(std::make_shared<CStringDataSource>(Document), ChunkSize);
+        EXPECT_EQ(EntityEvents(Reader), ExpectedEvents);
+        EXPECT_TRUE(Reader.End());
+    }
+    CXMLReader Broken(std::make_shared<CStringDataSource>("<root><a></root>"), 2);
+    EXPECT_FALSE(EntityEvents(Broken).empty());
+    SXMLEntity Entity;
+    EXPECT_FALSE(Broken.ReadEntity(Entity));
+}
+
+TEST(XMLReader, SuspendTest) {
+    std::string Document = "<root>";
+    for(int Index = 0; Index < 20; Index++){
+        Document += "<item n=\"" + std::to_string(Index) + "\"/>";
+    }
+    Document += "</root>";
+    CXMLReader Reader(std::make_shared<CStringDataSource>(Document));
+    CRecordingVisitor Visitor;
+    SXMLEntity Entity;
+    
+    // The whole document is one chunk, Expat stops after each entity so
+    // the rest is still parsed by the visitor
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DAttributes[0].second, "0");
+    EXPECT_FALSE(Reader.End());
+    EXPECT_TRUE(Reader.Parse(Visitor));
+    ASSERT_EQ(Visitor.DEvents.size(), 40);
+    EXPECT_EQ(Visitor.DEvents[0], "/item");
+    EXPECT_EQ(Visitor.DEvents[39], "/root");
+    EXPECT_TRUE(Reader.End());
+}
+
+TEST(XMLReader, CharDataLimitTest) {
+    std::string Document = "<root>abcdefghij<a/>     x<b/>\n  \n  <c/>ab  </root>";
+    std::vector<std::string> Expected({"<root", "#abcd", "#efgh", "#ij", "<a", "/a", "# x", "<b", "/b", "<c", "/c", "#  ab", "#  ", "/root"});
+    CXMLReader Reader(std::make_shared<CStringDataSource>(Document), 3);
+    Reader.SetLimits(4, 0);
+    // Runs never start with a piece of only whitespace, as without limits. A
+    // full one is dropped and a shorter one joins the next run, but once a
+    // run has started its pieces are handed on as they are.
+    EXPECT_EQ(EntityEvents(Reader), Expected);
+    EXPECT_TRUE(Reader.End());
+    
+    CXMLReader VisitorReader(std::make_shared<CStringDataSource>(Document));
+    CRecordingVisitor Visitor;
+    VisitorReader.SetLimits(4, 0);
+    EXPECT_TRUE(VisitorReader.Parse(Visitor));
+    EXPECT_EQ(Visitor.DEvents, Expected);
+    
+    CXMLReader Unlimited(std::make_shared<CStringDataSource>(Document));
+    EXPECT_EQ(EntityEvents(Unlimited), std::vector<std::string>({"<root", "#abcdefghij", "<a", "/a", "#     x", "<b", "/b", "<c", "/c", "#\n  \n  ab  ", "/root"}));
+}
+
+TEST(XMLReader, CharDataLimitWhitespaceTest) {
+    std::string Text = "abc" + std::string(20, ' ') + "def";
+    CXMLReader Reader(std::make_shared<CStringDataSource>("<a>" + Text + "</a>"));
+    Reader.SetLimits(8, 0);
+    SXMLEntity Entity;
+    std::string CharData;
+    while(Reader.ReadEntity(Entity)){
+        if(Entity.DType == SXMLEntity::EType::CharData){
+            EXPECT_LE(Entity.DNameData.size(), 8);
+            CharData += Entity.DNameData;
+        }
+    }
+    EXPECT_EQ(CharData, Text);
+}
+
+TEST(XMLReader, CharDataLimitSkipTest) {
+    // Each piece of text is queued on its own, skipping it must go on parsing
+    CXMLReader Reader(std::make_shared<CStringDataSource>("<a>hello world, long text<b/>tail</a>"));
+    Reader.SetLimits(5, 0);
+    SXMLEntity Entity;
+    std::vector<std::string> Events;
+    while(Reader.ReadEntity(Entity, true)){
+        Events.push_back((Entity.DType == SXMLEntity::EType::StartElement ? "<" : "/") + Entity.DNameData);
+    }
+    EXPECT_EQ(Events, std::vector<std::string>({"<a", "<b", "/b", "/a"}));
+    EXPECT_TRUE(Reader.End());
+}
+
+TEST(XMLReader, MarkupLimitTest) {
+    std::string Long(100, 'v');
+    std::string Document = "<?xml version=\"1.0\"?><!-- short --><root><a v=\"" + Long + "\"/></root>";
+    for(size_t ChunkSize : {1, 16, 1024}){
+        CXMLReader Reader(std::make_shared<CStringDataSource>(Document), ChunkSize);
+        Reader.SetLimits(0, 128);
+        EXPECT_EQ(EntityEvents(Reader).size(), 4);
+        EXPECT_TRUE(Reader.End());
+        
+        CXMLReader Limited(std::make_shared<CStringDataSource>(Document), ChunkSize);
+        Limited.SetLimits(0, 64);
+        EXPECT_EQ(EntityEvents(Limited), std::vector<std::string>({"<root"}));
+        
+        CXMLReader Comment(std::make_shared<CStringDataSource>("<root><!--" + Long + "--></root>"), ChunkSize);
+        Comment.SetLimits(0, 64);
+        EXPECT_EQ(EntityEvents(Comment), std::vector<std::string>({"<root"}));
+    }
+    // Attributes that grow through entity references are checked after expansion
+    std::string Expanding = "<!DOCTYPE r [<!ENTITY e \"" + Long + "\">]><r v=\"&e;\"/>";
+    CXMLReader Expanded(std::make_shared<CStringDataSource>(Expanding));
+    Expanded.SetLimits(0, 64);
+    EXPECT_TRUE(EntityEvents(Expanded).empty());
+    CXMLReader Unlimited(std::make_shared<CStringDataSource>(Expanding));
+    EXPECT_EQ(EntityEvents(Unlimited), std::vector<std::string>({"<r v=" + Long, "/r"}));
+}
+
+TEST(XMLReader, NameTableTest) {
+    CXMLNameTable Names;
+    
+    EXPECT_EQ(Names.Size(), 0);
+    EXPECT_EQ(Names.Find("a"), CXMLNameTable::NoName);
+    EXPECT_EQ(Names.Intern("a"), 1);
+    EXPECT_EQ(Names.Intern("bb"), 2);
+    EXPECT_EQ(Names.Intern("a"), 1);
+    EXPECT_EQ(Names.Find("bb"), 2);
+    EXPECT_EQ(Names.Name(2), "bb");
+    EXPECT_EQ(Names.Name(CXMLNameTable::NoName), "");
+    EXPECT_EQ(Names.Name(99), "");
+    EXPECT_EQ(Names.Size(), 2);
+    // Names are kept when many more are added
+    for(int Index = 0; Index < 1000; Index++){
+        Names.Intern("name" + std::to_string(Index));
+    }
+    EXPECT_EQ(Names.Find("bb"), 2);
+    EXPECT_EQ(Names.Name(1), "a");
+    EXPECT_EQ(Names.Name(Names.Find("name999")), "name999");
+}
+
+TEST(XMLReader, NameIDTest) {
+    CXMLReader Reader(std::make_shared<CStringDataSource>("<root id=\"r\"><item id=\"1\" k=\"v\">t</item><item id=\"2\"/></root>"));
+    Reader.InternNames();
+    auto ItemID = Reader.Names().Intern("item");
+    SXMLEntity Entity;
+    
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    auto RootID = Entity.DNameID;
+    EXPECT_EQ(Reader.Names().Name(RootID), "root");
+    auto IdID = Reader.Names().Find("id");
+    ASSERT_NE(IdID, CXMLNameTable::NoName);
+    EXPECT_EQ(Entity.DAttributeIDs, std::vector<SXMLEntity::TNameID>({IdID}));
+    EXPECT_EQ(Entity.AttributeValue(IdID), "r");
+    
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DNameID, ItemID);
+    EXPECT_TRUE(Entity.AttributeExists(Reader.Names().Find("k")));
+    EXPECT_EQ(Entity.AttributeValue(IdID), "1");
+    EXPECT_EQ(Entity.AttributeValue(Reader.Names().Find("k")), "v");
+    EXPECT_FALSE(Entity.AttributeExists(Reader.Names().Find("missing")));
+    // Attributes set by hand have no ID
+    EXPECT_TRUE(Entity.SetAttribute("extra", "x"));
+    EXPECT_EQ(Entity.DAttributeIDs.size(), 3);
+    EXPECT_FALSE(Entity.AttributeExists(CXMLNameTable::NoName));
+    
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DType, SXMLEntity::EType::CharData);
+    EXPECT_EQ(Entity.DNameID, CXMLNameTable::NoName);
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DType, SXMLEntity::EType::EndElement);
+    EXPECT_EQ(Entity.DNameID, ItemID);
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DNameID, ItemID);
+    EXPECT_EQ(Entity.AttributeValue(IdID), "2");
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DNameID, RootID);
+    EXPECT_EQ(Reader.Names().Size(), 4);
+}
+
+TEST(XMLReader, NameInterningLimitTest) {
+    std::string Document = "<root><item id=\"1\"/><other k=\"v\"/></root>";
+    CXMLReader Plain(std::make_shared<CStringDataSource>(Document));
+    SXMLEntity Entity;
+    
+    // Without InternNames no IDs are handed out and the table stays empty
+    EXPECT_TRUE(Plain.ReadEntity(Entity));
+    EXPECT_TRUE(Plain.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DNameData, "item");
+    EXPECT_EQ(Entity.DNameID, CXMLNameTable::NoName);
+    EXPECT_TRUE(Entity.DAttributeIDs.empty());
+    EXPECT_EQ(Entity.AttributeValue("id"), "1");
+    EXPECT_EQ(Plain.Names().Size(), 0);
+    
+    // A full table still finds the names already in it
+    CXMLReader Limited(std::make_shared<CStringDataSource>(Document));
+    Limited.InternNames(2);
+    auto OtherID = Limited.Names().Intern("other");
+    EXPECT_TRUE(Limited.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DNameID, Limited.Names().Find("root"));
+    EXPECT_TRUE(Limited.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DNameID, CXMLNameTable::NoName);
+    EXPECT_EQ(Entity.DAttributeIDs, std::vector<SXMLEntity::TNameID>({CXMLNameTable::NoName}));
+    EXPECT_TRUE(Limited.ReadEntity(Entity));
+    EXPECT_TRUE(Limited.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DNameID, OtherID);
+    EXPECT_EQ(Limited.Names().Size(), 2);
+}
+
+TEST(XMLReader, AttributeIndexTest) {
+    std::string Document = "<root";
+    for(int Index = 19; Index >= 0; Index--){
+        Document += " a" + std::to_string(Index) + "=\"v" + std::to_string(Index) + "\"";
+    }
+    Document += "><small b=\"1\" a=\"2\"/></root>";
+    CXMLReader Reader(std::make_shared<CStringDataSource>(Document));
+    SXMLEntity Entity;
+    Reader.InternNames();
+    
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    ASSERT_EQ(Entity.DAttributes.size(), 20);
+    EXPECT_EQ(Entity.DAttributeOrder.size(), 20);
+    for(int Index = 0; Index < 20; Index++){
+        std::string Name = "a" + std::to_string(Index);
+        EXPECT_EQ(Entity.AttributeView(Name), "v" + std::to_string(Index));
+        EXPECT_EQ(Entity.AttributeView(Reader.Names().Find(Name)), "v" + std::to_string(Index));
+        EXPECT_EQ(Entity.DAttributes[Entity.FindAttribute(Name)].first, Name);
+    }
+    EXPECT_FALSE(Entity.AttributeExists("a20"));
+    EXPECT_FALSE(Entity.AttributeExists("a"));
+    EXPECT_EQ(Entity.AttributeView("zz"), "");
+    // The index follows attributes set by hand
+    EXPECT_TRUE(Entity.SetAttribute("a5", "changed"));
+    EXPECT_TRUE(Entity.SetAttribute("a15b", "new"));
+    EXPECT_EQ(Entity.DAttributes.size(), 21);
+    EXPECT_EQ(Entity.AttributeView("a5"), "changed");
+    EXPECT_EQ(Entity.AttributeValue("a15b"), "new");
+    EXPECT_EQ(Entity.AttributeView("a15"), "v15");
+    
+    // The storage of the large element is reused for the next one
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DNameData, "small");
+    EXPECT_TRUE(Entity.DAttributeOrder.empty());
+    EXPECT_EQ(Entity.AttributeView("a"), "2");
+    EXPECT_EQ(Entity.AttributeView("a5"), "");
+}
+
+TEST(XMLReader, AttributeIndexBuildTest) {
+    SXMLEntity Entity;
+    Entity.DType = SXMLEntity::EType::StartElement;
+    Entity.DNameData = "e";
+    for(int Index = 0; Index < 16; Index++){
+        EXPECT_TRUE(Entity.SetAttribute("n" + std::to_string(15 - Index), std::to_string(Index)));
+    }
+    EXPECT_EQ(Entity.DAttributeOrder.size(), 16);
+    for(int Index = 0; Index < 16; Index++){
+        EXPECT_EQ(Entity.AttributeValue("n" + std::to_string(15 - Index)), std::to_string(Index));
+    }
+    // Attributes changed directly are found again after IndexAttributes
+    Entity.DAttributes[0].first = "renamed";
+    Entity.IndexAttributes();
+    EXPECT_EQ(Entity.AttributeView("renamed"), "0");
+    EXPECT_FALSE(Entity.AttributeExists("n15"));
+    Entity.DAttributes.push_back({"pushed", "p"});
+    EXPECT_EQ(Entity.AttributeView("pushed"), "p");
+}
+
 TEST(XMLWriter, EmptyTest) {
     auto Sink = std::make_shared<CStringDataSink>();
     CXMLWriter Writer(Sink);